@@ -1,5 +1,7 @@
 #include "animator.h"
 
+#include "nit3dyne/core/profiler.h"
+
 namespace n3d {
 
 Animator::Animator(Skin *skin) : skin(skin) {}
@@ -10,6 +12,8 @@ void Animator::setAnimation(Animation &animation) {
 }
 
 void Animator::update() {
+    N3D_PROFILE_SCOPE("Animator::update");
+
     if (this->animation == nullptr) {
         return;
     }
@@ -1,5 +1,7 @@
 #include "skin.h"
 
+#include "nit3dyne/core/profiler.h"
+
 namespace n3d {
 
 Joint *Skin::jointByNode(int nodeId) {
@@ -23,6 +25,7 @@ bool Skin::isJoint(int nodeId) {
 }
 
 void Skin::updateGlobalJointMatrices() {
+    N3D_PROFILE_SCOPE("Skin::updateGlobalJointMatrices");
     this->updateGlobalJointMatrices(this->rootJoint, this->globalTransform);
 }
 
@@ -20,6 +20,10 @@ mat4 Camera::getView() {
     return lookAt(this->position, this->position + this->front, this->up);
 }
 
+Frustum Camera::getFrustum() {
+    return Frustum(this->projection * this->getView());
+}
+
 void Camera::setFov(float fov) {
     if (fov < 5.f)
         fov = 5.f;
@@ -2,6 +2,7 @@
 #define GL_CAMERA_H
 
 #include "nit3dyne/core/math.h"
+#include "nit3dyne/camera/frustum.h"
 
 namespace n3d {
 
@@ -12,6 +13,7 @@ public:
     virtual ~Camera();
 
     virtual mat4 getView();
+    Frustum getFrustum();
     virtual void update();
     void setFov(float fov);
 
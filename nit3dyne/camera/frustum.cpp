@@ -0,0 +1,73 @@
+#include "frustum.h"
+
+#include <algorithm>
+
+namespace n3d {
+
+void transformAabb(const vec3 &min, const vec3 &max, const mat4 &modelMat, vec3 &worldMin, vec3 &worldMax) {
+    vec3 localCenter = (min + max) * .5f;
+    vec3 localExtent = (max - min) * .5f;
+    vec3 worldCenter = vec3(modelMat * vec4(localCenter, 1.f));
+    vec3 worldExtent(0.f);
+    for (int axis = 0; axis < 3; ++axis)
+        worldExtent += glm::abs(vec3(modelMat[axis])) * localExtent[axis];
+
+    worldMin = worldCenter - worldExtent;
+    worldMax = worldCenter + worldExtent;
+}
+
+Frustum::Frustum(const mat4 &viewProjection) {
+    // glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    this->planes[0] = rows[3] + rows[0];
+    this->planes[1] = rows[3] - rows[0];
+    this->planes[2] = rows[3] + rows[1];
+    this->planes[3] = rows[3] - rows[1];
+    this->planes[4] = rows[3] + rows[2];
+    this->planes[5] = rows[3] - rows[2];
+
+    for (vec4 &plane : this->planes)
+        plane /= glm::length(vec3(plane));
+}
+
+bool Frustum::containsSphere(const vec3 &center, float radius) const {
+    for (const vec4 &plane : this->planes) {
+        if (glm::dot(vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::containsAabb(const vec3 &min, const vec3 &max) const {
+    for (const vec4 &plane : this->planes) {
+        // Corner furthest along the plane normal
+        vec3 positive(
+                plane.x >= 0.f ? max.x : min.x,
+                plane.y >= 0.f ? max.y : min.y,
+                plane.z >= 0.f ? max.z : min.z
+        );
+        if (glm::dot(vec3(plane), positive) + plane.w < 0.f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::containsBounds(const vec3 &min, const vec3 &max, const vec3 &center, float radius,
+                             const mat4 &modelMat) const {
+    float scale = std::max({
+            glm::length(vec3(modelMat[0])),
+            glm::length(vec3(modelMat[1])),
+            glm::length(vec3(modelMat[2]))
+    });
+    if (!this->containsSphere(vec3(modelMat * vec4(center, 1.f)), radius * scale))
+        return false;
+
+    vec3 worldMin, worldMax;
+    transformAabb(min, max, modelMat, worldMin, worldMax);
+    return this->containsAabb(worldMin, worldMax);
+}
+
+}
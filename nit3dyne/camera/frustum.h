@@ -0,0 +1,35 @@
+#ifndef GL_FRUSTUM_H
+#define GL_FRUSTUM_H
+
+#include "nit3dyne/core/math.h"
+
+namespace n3d {
+
+// World box around a local box under modelMat (Arvo)
+void transformAabb(const vec3 &min, const vec3 &max, const mat4 &modelMat, vec3 &worldMin, vec3 &worldMax);
+
+// View frustum planes extracted from a view projection matrix (Gribb-Hartmann), normals point inwards
+class Frustum {
+public:
+    Frustum() = default;
+
+    explicit Frustum(const mat4 &viewProjection);
+
+    bool containsSphere(const vec3 &center, float radius) const;
+
+    bool containsAabb(const vec3 &min, const vec3 &max) const;
+
+    // Local bounds under modelMat, sphere first and then the transformed box
+    bool containsBounds(const vec3 &min, const vec3 &max, const vec3 &center, float radius,
+                        const mat4 &modelMat) const;
+
+    // Left, right, bottom, top, near, far. xyz normal, w distance. Default constructed contains everything.
+    vec4 planes[6] = {
+            vec4(0.f, 0.f, 0.f, 1.f), vec4(0.f, 0.f, 0.f, 1.f), vec4(0.f, 0.f, 0.f, 1.f),
+            vec4(0.f, 0.f, 0.f, 1.f), vec4(0.f, 0.f, 0.f, 1.f), vec4(0.f, 0.f, 0.f, 1.f)
+    };
+};
+
+}
+
+#endif // GL_FRUSTUM_H
@@ -1,50 +1,86 @@
 #include "display.h"
 
+#include <algorithm>
+#include <cmath>
+
 // TODO: Is this the best place for this?
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <tiny_gltf.h> // Includes stb libs
 
-namespace n3d {
+#include "nit3dyne/utils/golden_image.h"
 
-float QUAD_VERTICES[] = {
-    -1.0f,  1.0f,    0.0f, 1.0f,
-    -1.0f, -1.0f,    0.0f, 0.0f,
-    1.0f,  -1.0f,    1.0f, 0.0f,
-    -1.0f,  1.0f,    0.0f, 1.0f,
-    1.0f,  -1.0f,    1.0f, 0.0f,
-    1.0f,   1.0f,    1.0f, 1.0f
-};
+namespace n3d {
 
-void Display::init() {
+bool Display::init() {
     viewPort = std::pair<int, int>(1920, 1200);
-    viewPortVirtual = std::pair<int, int>(776, 485);
+    viewPortVirtualMax = std::pair<int, int>(776, 485);
+    viewPortVirtual = viewPortVirtualMax;
+    if (headless) viewPort = viewPortVirtualMax;
     title = "GlToy";
     shouldClose = false;
 
     frame = 0;
     timeLastFrame = 0.;
-    timeThisFrame = 0.;
+    timeStart = FramePacer::now();
+    timeThisFrame = timeStart;
     timeDelta = 0.;
-    target_frametime = 1. / 75.;
-
-    initGlfw();
+    time = 0.;
+    target_frametime = headless ? 0. : 1. / 75.;
+
+    if (headless) {
+        if (!initHeadless()) {
+            std::cout << "Display error: no headless OpenGL 3.3 context, is libEGL with a pbuffer config installed?"
+                      << std::endl;
+            shouldClose = true;
+            return false;
+        }
+    } else {
+        initGlfw();
+    }
     initGl();
     initBuffers();
     initResources();
+
+    Loader::init();
+    FrameUniforms::init();
+    LightClusters::init();
+    DebugDraw::init();
+    TextRenderer::init();
+
+    initialized = true;
+    return true;
 }
 
 void Display::destroy() {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDeleteFramebuffers(2, fbo);
-    glDeleteRenderbuffers(2, rbo);
-    glDeleteTextures(2, fboTexHandle);
-    glDeleteVertexArrays(1, &fboQuadVao);
+    // A failed headless init already released its context and made nothing else
+    if (!initialized) return;
+    initialized = false;
+
+    Loader::destroy();
+
+    GLState::bindFramebuffer(0);
+    GLState::deleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &rbo);
+    GLState::deleteTextures(1, &fboTexHandle);
 
-    delete copyShader;
+    delete postGraph;
+    delete resolutionController;
+    delete gpuTimer;
     delete dither;
 
+    GeometryPool::destroy();
+    TextRenderer::destroy();
+    DebugDraw::destroy();
+    LightClusters::destroy();
+    FrameUniforms::destroy();
+
+    if (headless) {
+        HeadlessContext::destroy();
+        return;
+    }
+
     glfwDestroyWindow(window);
     glfwTerminate();
 }
@@ -60,121 +96,197 @@ void Display::initGlfw() {
 
     window = glfwCreateWindow(viewPort.first, viewPort.second, title.c_str(), NULL, NULL);
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(0); // Paced by update(), see setVsync
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
 
     gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
 }
 
-void Display::initGl() {
-    glViewport(0, 0, viewPort.first, viewPort.second);
-
-//    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-}
+bool Display::initHeadless() {
+    window = nullptr;
+    if (!HeadlessContext::create(viewPort.first, viewPort.second)) return false;
 
-void Display::initBuffers() {
-    glGenFramebuffers(2, fbo);
-    glGenTextures(2, fboTexHandle);
-    glGenRenderbuffers(2, rbo);
-
-    for (size_t i = 0; i < sizeof(fbo) / sizeof(unsigned int); i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, fbo[i]);
-
-        glBindTexture(GL_TEXTURE_2D, fboTexHandle[i]);
-        glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RGB,
-                viewPortVirtual.first,
-                viewPortVirtual.second,
-                0,
-                GL_RGB,
-                GL_UNSIGNED_BYTE,
-                NULL
-        );
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fboTexHandle[i], 0);
-
-        glBindRenderbuffer(GL_RENDERBUFFER, rbo[i]);
-        glRenderbufferStorage(
-                GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, viewPortVirtual.first, viewPortVirtual.second
-        );
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo[i]);
-
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "ERROR: Framebuffer is not complete!" << std::endl;
+    if (!gladLoadGLLoader((GLADloadproc) HeadlessContext::getProcAddress)) {
+        HeadlessContext::destroy();
+        return false;
     }
+    return true;
+}
 
-    unsigned int quadVbo;
-    glGenVertexArrays(1, &fboQuadVao);
-    glGenBuffers(1, &quadVbo);
+void Display::initGl() {
+    GLState::invalidate();
 
-    glBindVertexArray(fboQuadVao);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), &QUAD_VERTICES, GL_STATIC_DRAW);
+    GLState::viewport(0, 0, viewPort.first, viewPort.second);
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) (2 * sizeof(float)));
+//    GLState::enable(GL_CULL_FACE);
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
 
-    glBindVertexArray(0);
+void Display::initBuffers() {
+    // Scene target at the largest virtual resolution, smaller ones use part of it.
+    // Post effects read it through the render graph.
+    glGenFramebuffers(1, &fbo);
+    glGenTextures(1, &fboTexHandle);
+    glGenRenderbuffers(1, &rbo);
+
+    GLState::bindFramebuffer(fbo);
+
+    GLState::bindTexture(GL_TEXTURE_2D, fboTexHandle);
+    glTexImage2D(
+            GL_TEXTURE_2D,
+            0,
+            GL_RGB,
+            viewPortVirtualMax.first,
+            viewPortVirtualMax.second,
+            0,
+            GL_RGB,
+            GL_UNSIGNED_BYTE,
+            NULL
+    );
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fboTexHandle, 0);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, viewPortVirtualMax.first, viewPortVirtualMax.second);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR: Framebuffer is not complete!" << std::endl;
+
+    GLState::viewport(0, 0, viewPortVirtual.first, viewPortVirtual.second);
 }
 
 void Display::update() {
     timeLastFrame = timeThisFrame;
-    timeThisFrame = glfwGetTime();
-    while ((timeThisFrame - timeLastFrame) < target_frametime)
-        timeThisFrame = glfwGetTime();
+    pacer.targetTime = target_frametime;
+    timeThisFrame = pacer.wait();
+    N3D_PROFILE_FRAME();
+
+    // GPU timing starts after the pacing wait, an idle GPU during the wait must not count as frame time
+    gpuTimer->beginFrame();
+    gpuTimer->begin("scene");
+    updateResolution();
+    GLState::viewport(0, 0, viewPortVirtual.first, viewPortVirtual.second);
 
     timeDelta = timeThisFrame - timeLastFrame;
+    time = timeThisFrame - timeStart;
     ++frame;
 
-    shouldClose = (bool) glfwWindowShouldClose(window);
+    // Finish async resource loads within the frame's upload budget
+    Loader::processUploads(Loader::uploadBudget);
+
+    if (!headless) shouldClose = (bool) glfwWindowShouldClose(window);
 }
 
-void Display::flip(Shader &postShader) {
-    // Bind intermediate fb for applying post effects
-    glDisable(GL_DEPTH_TEST);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo[1]);
-    glClear(GL_COLOR_BUFFER_BIT);
+void Display::setVsync(bool enabled) {
+    if (headless) return;
 
-    postShader.use();
-    postShader.setUniform("grainSeed", randFloat(0.f, 1.f));
-    glBindVertexArray(fboQuadVao); // VAO is shared for both copies
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, fboTexHandle[0]); // bind intermediate tex
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glfwSwapInterval(enabled ? 1 : 0);
+    pacer.vsync = enabled;
+    pacer.reset();
+}
+
+void Display::addPostEffect(const std::string &name, const std::string &effectPath, bool pointwise) {
+    postEffects.push_back({name, effectPath, pointwise});
+    buildPostGraph();
+}
+
+void Display::clearPostEffects() {
+    postEffects.clear();
+    buildPostGraph();
+}
+
+void Display::buildPostGraph() {
+    postGraph->clear();
+    postGraph->setBackbufferSize(viewPort.first, viewPort.second);
+
+    // Effects run at the virtual resolution, the final copy upscales. Pointwise effects and the copy
+    // fuse into one draw, with no effects the copy is a blit.
+    postTargets.clear();
+    RenderGraph::Target input = postGraph->importTarget(fbo, fboTexHandle, viewPortVirtualMax.first,
+                                                        viewPortVirtualMax.second);
+    postTargets.push_back(input);
+    for (const PostEffect &effect : postEffects) {
+        RenderGraph::Target output = postGraph->createTarget(viewPortVirtualMax.first, viewPortVirtualMax.second);
+        postGraph->addPass(effect.name, effect.effectPath, input, output, effect.pointwise);
+        postTargets.push_back(output);
+        input = output;
+    }
+    postGraph->addPass("upscale", "", input, RenderGraph::BACKBUFFER);
+
+    for (RenderGraph::Target target : postTargets)
+        postGraph->setRegion(target, viewPortVirtual.first, viewPortVirtual.second);
+}
+
+void Display::updateResolution() {
+    // Fed even when disabled, so turning it back on starts from recent measurements
+    float scale = resolutionController->update(*gpuTimer);
+    if (!dynamicResolution) scale = 1.f;
+
+    std::pair<int, int> size(
+            std::max(1, (int) std::lround(viewPortVirtualMax.first * scale)),
+            std::max(1, (int) std::lround(viewPortVirtualMax.second * scale))
+    );
+    if (size == viewPortVirtual) return;
+
+    // Only the used region changes, no target is reallocated
+    viewPortVirtual = size;
+    for (RenderGraph::Target target : postTargets)
+        postGraph->setRegion(target, size.first, size.second);
+}
 
-    // Bind main fb
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(0, 0, viewPort.first, viewPort.second);
-    glClear(GL_COLOR_BUFFER_BIT);
+void Display::captureFrame(const std::string &path) {
+    capturePath = path;
+}
+
+void Display::saveBackbuffer(const std::string &path) {
+    std::vector<unsigned char> pixels((size_t) viewPort.first * viewPort.second * 3);
+
+    GLState::bindFramebuffers(0, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, viewPort.first, viewPort.second, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    saveImage(path, viewPort.first, viewPort.second, pixels.data());
+}
+
+void Display::flip() {
+    N3D_PROFILE_SCOPE("Display::flip");
 
-    // copy intermediate fb to main fb and swap
-    copyShader->use(); // Use copy shader
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, fboTexHandle[1]);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, dither->handle);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glfwSwapBuffers(window);
+    gpuTimer->end("scene");
+
+    postGraph->setUniform("grainSeed", randFloat(0.f, 1.f));
+    postGraph->execute(gpuTimer);
+
+    if (!capturePath.empty()) {
+        saveBackbuffer(capturePath);
+        capturePath.clear();
+    }
+
+    // Fence after the frame's last draw, stream ranges it used are reusable once it passes
+    StreamBuffer::endFrames();
+    gpuTimer->endFrame();
+    if (headless)
+        HeadlessContext::swapBuffers();
+    else
+        glfwSwapBuffers(window);
 
     // switch back to virtual fb before next frame
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo[0]);
-    glViewport(0, 0, viewPortVirtual.first, viewPortVirtual.second);
-    glEnable(GL_DEPTH_TEST);
+    GLState::bindFramebuffer(fbo);
+    GLState::viewport(0, 0, viewPortVirtual.first, viewPortVirtual.second);
 }
 
 void Display::initResources() {
     dither = new Texture("dith");
 
-    copyShader = new Shader("shaders/copy.vert", "shaders/copy.frag");
-    copyShader->use();
-    copyShader->setUniform("tex", 0);
+    resolutionController = new DynamicResolution();
+    gpuTimer = new GpuTimer();
+
+    postGraph = new RenderGraph();
+    postGraph->setTexture("texDither", *dither);
+    buildPostGraph();
 }
 
 }
\ No newline at end of file
@@ -2,18 +2,42 @@
 #define GL_DISPLAY_H
 
 #include <string>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "nit3dyne/graphics/shader.h"
 #include "nit3dyne/graphics/texture.h"
+#include "nit3dyne/graphics/geometry_pool.h"
+#include "nit3dyne/graphics/frame_uniforms.h"
+#include "nit3dyne/graphics/debug_draw.h"
+#include "nit3dyne/graphics/light_clusters.h"
+#include "nit3dyne/graphics/render_graph.h"
+#include "nit3dyne/graphics/dynamic_resolution.h"
+#include "nit3dyne/core/loader.h"
+#include "nit3dyne/core/textRenderer.h"
+#include "nit3dyne/core/framePacer.h"
+#include "nit3dyne/core/headlessContext.h"
+#include "nit3dyne/core/profiler.h"
 #include "nit3dyne/utils/rand.h"
+#include "nit3dyne/graphics/gl_state.h"
 
 namespace n3d {
 
 class Display {
 public:
     inline static std::pair<int, int> viewPort;
-    inline static std::pair<int, int> viewPortVirtual;
+    inline static std::pair<int, int> viewPortVirtual;    // Render size this frame
+    inline static std::pair<int, int> viewPortVirtualMax; // Allocated render size
+
+    // Scales the render size to hold resolutionController's GPU frame time target
+    inline static bool dynamicResolution = false;
+    inline static DynamicResolution *resolutionController;
+
+    // Times every frame from update() as "frame", the scene up to flip() as "scene" and each post draw, see GpuTimer
+    inline static GpuTimer *gpuTimer;
+
+    // Set before init: no window, an offscreen EGL context at the virtual resolution, unpaced. Input is unavailable.
+    inline static bool headless = false;
 
     inline static std::string title;
     inline static GLFWwindow *window;
@@ -21,36 +45,70 @@ public:
 
     inline static long frame;
     inline static double timeDelta;
+    inline static double time; // Seconds since init when the frame started, FramePacer's clock
     inline static double target_frametime;
 
-    static void init();
+    // Holds update() to target_frametime, its statistics show the pacing error
+    inline static FramePacer pacer;
+
+    // False when headless and no context could be made, shouldClose is then set and nothing else may be called
+    static bool init();
 
     static void destroy();
 
     static void update();
 
-    static void flip(Shader &postShader);
+    // Leaves pacing to the buffer swap, at the monitor's refresh rate
+    static void setVsync(bool enabled);
+
+    // Effect files under shaders/, see RenderGraph. Applied in order at the virtual resolution.
+    static void addPostEffect(const std::string &name, const std::string &effectPath, bool pointwise = true);
+
+    static void clearPostEffects();
+
+    // Writes the next flip()'s final image to a PNG, see utils/golden_image.h for comparing it
+    static void captureFrame(const std::string &path);
+
+    // Post effects, upscale to the window and swap
+    static void flip();
 
 private:
+    inline static bool initialized = false;
+    inline static double timeStart;
     inline static double timeLastFrame;
     inline static double timeThisFrame;
+    inline static std::string capturePath;
 
-    inline static Shader *copyShader;
-    inline static Texture *dither;
+    struct PostEffect {
+        std::string name;
+        std::string effectPath;
+        bool pointwise;
+    };
 
-    inline static unsigned int fbo[2];
-    inline static unsigned int rbo[2];
-    inline static unsigned int fboTexHandle[2];
-    inline static unsigned int fboQuadVao;
+    inline static Texture *dither;
+    inline static RenderGraph *postGraph;
+    inline static std::vector<PostEffect> postEffects;
+    inline static std::vector<RenderGraph::Target> postTargets; // Sized with the render size
 
+    inline static unsigned int fbo;
+    inline static unsigned int rbo;
+    inline static unsigned int fboTexHandle;
 
     static void initGlfw();
 
+    static bool initHeadless();
+
     static void initGl();
 
     static void initBuffers();
 
     static void initResources();
+
+    static void buildPostGraph();
+
+    static void updateResolution();
+
+    static void saveBackbuffer(const std::string &path);
 };
 
 }
@@ -0,0 +1,107 @@
+#include "framePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__unix__)
+#include <cerrno>
+#include <time.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace n3d {
+
+// Weight of a new wake up lateness in the smoothed one, rises to a larger one at once
+const double LATENESS_SMOOTHING = .05;
+
+double FramePacer::now() {
+#if defined(__unix__)
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+#else
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void FramePacer::sleepUntil(double time) {
+#if defined(__unix__)
+    // Absolute on the same clock as now(), an interrupted sleep resumes towards the same time
+    timespec until;
+    until.tv_sec = (time_t) time;
+    until.tv_nsec = (long) ((time - (double) until.tv_sec) * 1e9);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR) {}
+#else
+    std::this_thread::sleep_for(std::chrono::duration<double>(time - now()));
+#endif
+}
+
+double FramePacer::wait() {
+    double time = now();
+    double slept = 0.;
+    double spun = 0.;
+
+    // A frame that ran late starts a new schedule rather than shortening the next ones to catch up
+    if (this->deadline == 0. || time > this->deadline) this->deadline = time;
+
+    if (!this->vsync && this->deadline > time) {
+        double wake = this->deadline - this->spinTime - this->lateness;
+        if (wake > time) {
+            sleepUntil(wake);
+            double woke = now();
+
+            double late = std::max(woke - wake, 0.);
+            this->lateness = late > this->lateness ? late
+                                                   : this->lateness + (late - this->lateness) * LATENESS_SMOOTHING;
+            slept = woke - time;
+            time = woke;
+        }
+
+        double spinStart = time;
+        while (time < this->deadline)
+            time = now();
+        spun = time - spinStart;
+    }
+
+    if (this->last != 0.) record(time - this->last, slept, spun);
+    this->last = time;
+    this->deadline += this->targetTime;
+
+    return time;
+}
+
+void FramePacer::reset() {
+    this->deadline = 0.;
+    this->last = 0.;
+}
+
+void FramePacer::record(double interval, double slept, double spun) {
+    double error = interval - this->targetTime;
+    ++this->frames;
+    this->errorSum += error;
+    this->errorSquares += error * error;
+    this->errorPeak = std::max(this->errorPeak, std::abs(error));
+    this->sleptSum += slept;
+    this->spunSum += spun;
+
+    if (this->frames < this->statsFrames) return;
+
+    // The deviation of the interval is the deviation of the error, targetTime is constant
+    double mean = this->errorSum / this->frames;
+    this->errorMean = mean;
+    this->errorMax = this->errorPeak;
+    this->errorDeviation = std::sqrt(std::max(this->errorSquares / this->frames - mean * mean, 0.));
+    double waited = this->sleptSum + this->spunSum;
+    this->spinShare = waited > 0. ? this->spunSum / waited : 0.;
+
+    this->frames = 0;
+    this->errorSum = 0.;
+    this->errorSquares = 0.;
+    this->errorPeak = 0.;
+    this->sleptSum = 0.;
+    this->spunSum = 0.;
+}
+
+}
@@ -0,0 +1,59 @@
+#ifndef GL_FRAME_PACER_H
+#define GL_FRAME_PACER_H
+
+namespace n3d {
+
+/*
+ * Holds frames to a target interval without burning a core. wait() sleeps on a high resolution
+ * timer until shortly before the deadline and spins only for the rest. The margin is the measured
+ * wake up lateness of the timer plus spinTime, so a slow timer costs some spinning, not late frames.
+ */
+class FramePacer {
+public:
+    // Seconds between frames
+    double targetTime = 1. / 75.;
+
+    // Spun before the deadline on top of the timer's measured lateness, in seconds
+    double spinTime = .0005;
+
+    // Frames are paced by the buffer swap, wait() only measures
+    bool vsync = false;
+
+    // Frames per statistics window
+    int statsFrames = 120;
+
+    // Blocks until the next frame is due and returns the time, in seconds on now()'s clock
+    double wait();
+
+    // Forgets the schedule, e.g. after a long stall like a load
+    void reset();
+
+    // Monotonic, in seconds
+    static double now();
+
+    // Results of the last full window, in seconds
+    double errorMean = 0.;      // Frame interval minus targetTime, positive when late
+    double errorMax = 0.;       // Largest distance from targetTime
+    double errorDeviation = 0.; // Of the frame interval
+    double spinShare = 0.;      // Part of the waiting spent spinning
+
+private:
+    static void sleepUntil(double time);
+
+    void record(double interval, double slept, double spun);
+
+    double deadline = 0.;
+    double last = 0.;
+    double lateness = 0.; // Timer wake up lateness, smoothed
+
+    int frames = 0;
+    double errorSum = 0.;
+    double errorSquares = 0.;
+    double errorPeak = 0.;
+    double sleptSum = 0.;
+    double spunSum = 0.;
+};
+
+}
+
+#endif // GL_FRAME_PACER_H
@@ -0,0 +1,172 @@
+#include "headlessContext.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <dlfcn.h>
+
+namespace n3d {
+
+// The little of EGL used, declared here so no EGL headers are needed to build
+typedef void *EGLDisplay;
+typedef void *EGLConfig;
+typedef void *EGLContext;
+typedef void *EGLSurface;
+typedef int EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+
+const EGLint EGL_NONE = 0x3038;
+const EGLint EGL_RED_SIZE = 0x3024;
+const EGLint EGL_GREEN_SIZE = 0x3023;
+const EGLint EGL_BLUE_SIZE = 0x3022;
+const EGLint EGL_DEPTH_SIZE = 0x3025;
+const EGLint EGL_STENCIL_SIZE = 0x3026;
+const EGLint EGL_SURFACE_TYPE = 0x3033;
+const EGLint EGL_PBUFFER_BIT = 0x0001;
+const EGLint EGL_RENDERABLE_TYPE = 0x3040;
+const EGLint EGL_OPENGL_BIT = 0x0008;
+const EGLint EGL_WIDTH = 0x3057;
+const EGLint EGL_HEIGHT = 0x3056;
+const EGLint EGL_EXTENSIONS = 0x3055;
+const EGLint EGL_CONTEXT_MAJOR_VERSION = 0x3098;
+const EGLint EGL_CONTEXT_MINOR_VERSION = 0x30FB;
+const EGLint EGL_CONTEXT_OPENGL_PROFILE_MASK = 0x30FD;
+const EGLint EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT = 0x0001;
+const EGLenum EGL_OPENGL_API = 0x30A2;
+const EGLenum EGL_PLATFORM_SURFACELESS_MESA = 0x31DD;
+
+struct Egl {
+    void *(*getProcAddress)(const char *);
+    EGLDisplay (*getDisplay)(void *);
+    EGLBoolean (*initialize)(EGLDisplay, EGLint *, EGLint *);
+    EGLBoolean (*terminate)(EGLDisplay);
+    const char *(*queryString)(EGLDisplay, EGLint);
+    EGLBoolean (*bindApi)(EGLenum);
+    EGLBoolean (*chooseConfig)(EGLDisplay, const EGLint *, EGLConfig *, EGLint, EGLint *);
+    EGLContext (*createContext)(EGLDisplay, EGLConfig, EGLContext, const EGLint *);
+    EGLBoolean (*destroyContext)(EGLDisplay, EGLContext);
+    EGLSurface (*createPbufferSurface)(EGLDisplay, EGLConfig, const EGLint *);
+    EGLBoolean (*destroySurface)(EGLDisplay, EGLSurface);
+    EGLBoolean (*makeCurrent)(EGLDisplay, EGLSurface, EGLSurface, EGLContext);
+    EGLBoolean (*swapBuffers)(EGLDisplay, EGLSurface);
+};
+
+static Egl egl;
+
+template<typename T>
+static bool load(void *library, T &function, const char *name) {
+    function = (T) dlsym(library, name);
+    return function != nullptr;
+}
+
+bool HeadlessContext::create(int width, int height) {
+    library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr) library = dlopen("libEGL.so", RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr) {
+        std::cout << "Headless context error: libEGL not found" << std::endl;
+        return false;
+    }
+
+    bool loaded = load(library, egl.getProcAddress, "eglGetProcAddress")
+                  && load(library, egl.getDisplay, "eglGetDisplay")
+                  && load(library, egl.initialize, "eglInitialize")
+                  && load(library, egl.terminate, "eglTerminate")
+                  && load(library, egl.queryString, "eglQueryString")
+                  && load(library, egl.bindApi, "eglBindAPI")
+                  && load(library, egl.chooseConfig, "eglChooseConfig")
+                  && load(library, egl.createContext, "eglCreateContext")
+                  && load(library, egl.destroyContext, "eglDestroyContext")
+                  && load(library, egl.createPbufferSurface, "eglCreatePbufferSurface")
+                  && load(library, egl.destroySurface, "eglDestroySurface")
+                  && load(library, egl.makeCurrent, "eglMakeCurrent")
+                  && load(library, egl.swapBuffers, "eglSwapBuffers");
+    if (!loaded) {
+        std::cout << "Headless context error: libEGL is missing functions" << std::endl;
+        destroy();
+        return false;
+    }
+
+    // Surfaceless needs no X or Wayland server, other platforms may pick one up from the environment
+    const char *clientExtensions = egl.queryString(nullptr, EGL_EXTENSIONS);
+    auto getPlatformDisplay = (EGLDisplay (*)(EGLenum, void *, const EGLint *)) egl.getProcAddress(
+            "eglGetPlatformDisplayEXT");
+    if (clientExtensions != nullptr && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr
+        && getPlatformDisplay != nullptr)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+    if (display == nullptr) display = egl.getDisplay(nullptr);
+
+    if (display == nullptr || !egl.initialize(display, nullptr, nullptr)) {
+        std::cout << "Headless context error: no EGL display" << std::endl;
+        display = nullptr;
+        destroy();
+        return false;
+    }
+
+    const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+    };
+    const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+    };
+    const EGLint surfaceAttributes[] = {
+            EGL_WIDTH, width,
+            EGL_HEIGHT, height,
+            EGL_NONE
+    };
+
+    EGLConfig config = nullptr;
+    EGLint configs = 0;
+    if (!egl.bindApi(EGL_OPENGL_API) || !egl.chooseConfig(display, configAttributes, &config, 1, &configs)
+        || configs == 0) {
+        std::cout << "Headless context error: no OpenGL pbuffer config" << std::endl;
+        destroy();
+        return false;
+    }
+
+    context = egl.createContext(display, config, nullptr, contextAttributes);
+    surface = egl.createPbufferSurface(display, config, surfaceAttributes);
+    if (context == nullptr || surface == nullptr || !egl.makeCurrent(display, surface, surface, context)) {
+        std::cout << "Headless context error: could not create an OpenGL 3.3 core context" << std::endl;
+        destroy();
+        return false;
+    }
+
+    return true;
+}
+
+void HeadlessContext::destroy() {
+    if (display != nullptr) {
+        egl.makeCurrent(display, nullptr, nullptr, nullptr);
+        if (surface != nullptr) egl.destroySurface(display, surface);
+        if (context != nullptr) egl.destroyContext(display, context);
+        egl.terminate(display);
+    }
+    display = nullptr;
+    context = nullptr;
+    surface = nullptr;
+
+    if (library != nullptr) dlclose(library);
+    library = nullptr;
+}
+
+void *HeadlessContext::getProcAddress(const char *name) {
+    return egl.getProcAddress(name);
+}
+
+void HeadlessContext::swapBuffers() {
+    // Pbuffers have no back buffer, this only keeps the frame boundary visible to the driver
+    egl.swapBuffers(display, surface);
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef GL_HEADLESS_CONTEXT_H
+#define GL_HEADLESS_CONTEXT_H
+
+namespace n3d {
+
+/*
+ * OpenGL 3.3 core context without a window, for benchmarks and image tests. libEGL is loaded at
+ * run time, so nothing links against it; Mesa's surfaceless platform is used when present and
+ * runs on llvmpipe without a GPU. The default framebuffer is a pbuffer of the given size.
+ */
+class HeadlessContext {
+public:
+    // Makes the context current, false with an error printed when EGL is missing or refuses
+    static bool create(int width, int height);
+
+    static void destroy();
+
+    // For gladLoadGLLoader
+    static void *getProcAddress(const char *name);
+
+    static void swapBuffers();
+
+private:
+    // EGL handles, typed in the source
+    inline static void *library = nullptr;
+    inline static void *display = nullptr;
+    inline static void *context = nullptr;
+    inline static void *surface = nullptr;
+};
+
+}
+
+#endif // GL_HEADLESS_CONTEXT_H
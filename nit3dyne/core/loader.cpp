@@ -0,0 +1,74 @@
+#include "loader.h"
+
+#include <chrono>
+
+namespace n3d {
+
+void Loader::init(size_t threads, size_t maxUploads) {
+    Loader::maxUploads = maxUploads;
+    Loader::stopping = false;
+    Loader::pool = new ThreadPool(threads);
+}
+
+void Loader::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        uploads.clear();
+    }
+    notFull.notify_all();
+
+    delete pool;
+    pool = nullptr;
+}
+
+void Loader::submit(std::function<void()> job) {
+    if (pool == nullptr) {
+        job();
+        return;
+    }
+
+    pool->submit(std::move(job));
+}
+
+void Loader::parallelFor(size_t count, const std::function<void(size_t)> &job) {
+    if (pool == nullptr) {
+        for (size_t i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+
+    pool->parallelFor(count, job);
+}
+
+void Loader::queueUpload(std::function<void()> upload) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (pool != nullptr)
+        notFull.wait(lock, [] { return stopping || uploads.size() < maxUploads; });
+    if (stopping) return;
+
+    uploads.push_back(std::move(upload));
+}
+
+void Loader::processUploads(double budget) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (;;) {
+        std::function<void()> upload;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (uploads.empty()) return;
+
+            upload = std::move(uploads.front());
+            uploads.pop_front();
+        }
+        notFull.notify_one();
+
+        upload();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budget) return;
+    }
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef GL_LOADER_H
+#define GL_LOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+
+#include "nit3dyne/core/threadPool.h"
+
+namespace n3d {
+
+/*
+ * Background resource loading. Jobs decode files on worker threads, then queue their GL upload,
+ * the render thread drains the upload queue within a time budget each frame. The workers also run
+ * the parallel loops of other systems, so the engine never has more threads than cores.
+ */
+class Loader {
+public:
+    inline static double uploadBudget = 0.002; // seconds per frame
+
+    static void init(size_t threads = 0, size_t maxUploads = 64);
+
+    static void destroy();
+
+    // Runs on a worker thread, or inline if the loader is not initialized
+    static void submit(std::function<void()> job);
+
+    // ThreadPool::parallelFor on the same workers, the engine's one pool. Inline if the loader is not initialized.
+    static void parallelFor(size_t count, const std::function<void(size_t)> &job);
+
+    // Called from workers, blocks while the upload queue is full
+    static void queueUpload(std::function<void()> upload);
+
+    // Render thread only, runs at least one pending upload then continues until budget seconds have passed
+    static void processUploads(double budget);
+
+    // Render thread only, drains uploads until the future is ready
+    template<typename T>
+    static void wait(const std::shared_future<T> &future);
+
+private:
+    inline static ThreadPool *pool = nullptr;
+
+    inline static std::deque<std::function<void()>> uploads;
+    inline static size_t maxUploads;
+    inline static std::mutex mutex;
+    inline static std::condition_variable notFull;
+    inline static bool stopping = false;
+};
+
+template<typename T>
+void Loader::wait(const std::shared_future<T> &future) {
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        processUploads(0.);
+        std::this_thread::yield();
+    }
+}
+
+}
+
+#endif // GL_LOADER_H
@@ -0,0 +1,133 @@
+#include "profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include <json.hpp>
+
+namespace n3d {
+
+const auto PROFILER_EPOCH = std::chrono::steady_clock::now();
+
+uint64_t Profiler::now() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - PROFILER_EPOCH
+    ).count();
+}
+
+Profiler::Ring &Profiler::ring() {
+    if (threadRing != nullptr) return *threadRing;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto ring = std::make_unique<Ring>();
+    ring->events.resize(ringSize);
+    ring->thread = (uint32_t) rings.size();
+    threadRing = ring.get();
+    rings.push_back(std::move(ring));
+    return *threadRing;
+}
+
+bool Profiler::push(Ring &ring, const char *name, EventType type, size_t reserve) {
+    size_t head = ring.head.load(std::memory_order_relaxed);
+    size_t used = head - ring.tail.load(std::memory_order_acquire);
+    if (used + reserve > ring.events.size()) {
+        ++dropped;
+        return false;
+    }
+
+    ring.events[head % ring.events.size()] = {name, now(), type, ring.thread};
+    ring.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool Profiler::begin(const char *name) {
+    if (!enabled.load(std::memory_order_relaxed)) return false;
+
+    Ring &ring = Profiler::ring();
+    if (!push(ring, name, EventType::BEGIN, ring.depth + 2)) return false;
+    ++ring.depth;
+    return true;
+}
+
+void Profiler::end() {
+    Ring &ring = Profiler::ring();
+    // Room was reserved by begin
+    push(ring, nullptr, EventType::END, 1);
+    --ring.depth;
+}
+
+void Profiler::frame() {
+    if (enabled.load(std::memory_order_relaxed)) {
+        Ring &ring = Profiler::ring();
+        push(ring, "Frame", EventType::FRAME, ring.depth + 1);
+    }
+
+    collect();
+}
+
+void Profiler::collect() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &ring : rings) {
+        size_t tail = ring->tail.load(std::memory_order_relaxed);
+        size_t head = ring->head.load(std::memory_order_acquire);
+
+        for (size_t i = tail; i < head; ++i) {
+            if (store.size() < maxEvents)
+                store.push_back(ring->events[i % ring->events.size()]);
+            else
+                ++dropped;
+        }
+        ring->tail.store(head, std::memory_order_release);
+    }
+}
+
+bool Profiler::save(const std::string &path) {
+    collect();
+
+    nlohmann::json events = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Event &event : store) {
+            nlohmann::json entry = {
+                    {"ts",  (double) event.time * 1e-3},
+                    {"pid", 0},
+                    {"tid", event.thread}
+            };
+            if (event.type == EventType::BEGIN) {
+                entry["name"] = event.name;
+                entry["ph"] = "B";
+            } else if (event.type == EventType::END) {
+                entry["ph"] = "E";
+            } else {
+                entry["name"] = event.name;
+                entry["ph"] = "i";
+                entry["s"] = "g";
+            }
+            events.push_back(std::move(entry));
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file) {
+        std::cout << "Profiler error: could not write " << path << std::endl;
+        return false;
+    }
+
+    nlohmann::json trace = {
+            {"traceEvents",     std::move(events)},
+            {"displayTimeUnit", "ms"}
+    };
+    file << trace.dump();
+    return true;
+}
+
+void Profiler::clear() {
+    collect();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    store.clear();
+    dropped = 0;
+}
+
+}
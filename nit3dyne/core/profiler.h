@@ -0,0 +1,115 @@
+#ifndef GL_PROFILER_H
+#define GL_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * CPU zones, built with the NIT3DYNE_PROFILER CMake option. Without it the macros expand to nothing.
+ *
+ *   N3D_PROFILE_SCOPE("Model::draw"); // Times the rest of the enclosing block, the name must be a literal
+ *   N3D_PROFILE_FRAME();              // Marks a frame and collects every thread's events
+ */
+#ifdef N3D_PROFILE
+#define N3D_PROFILE_JOIN_(a, b) a##b
+#define N3D_PROFILE_JOIN(a, b) N3D_PROFILE_JOIN_(a, b)
+#define N3D_PROFILE_SCOPE(name) ::n3d::ProfileScope N3D_PROFILE_JOIN(profileScope, __LINE__)(name)
+#define N3D_PROFILE_FRAME() ::n3d::Profiler::frame()
+#else
+#define N3D_PROFILE_SCOPE(name) ((void) 0)
+#define N3D_PROFILE_FRAME() ((void) 0)
+#endif
+
+namespace n3d {
+
+/*
+ * Every thread writes begin and end events to its own ring, read without locks by frame() on the
+ * render thread into one store. A zone is only begun while its end and the ends of the zones open
+ * around it still fit, so a full ring drops whole zones and the trace stays balanced.
+ */
+class Profiler {
+public:
+    // Events per thread between two frames
+    inline static size_t ringSize = 1 << 14;
+
+    // Events kept until clear, later ones are dropped
+    inline static size_t maxEvents = 1 << 22;
+
+    // Off stops recording, zones then cost a branch
+    inline static std::atomic<bool> enabled{true};
+
+    // False when the zone was not recorded, its end must then be skipped
+    static bool begin(const char *name);
+
+    static void end();
+
+    static void frame();
+
+    // Collects and writes the events in Chrome's trace format, for chrome://tracing or Perfetto
+    static bool save(const std::string &path);
+
+    static void clear();
+
+    // Events lost to full rings or the store limit
+    inline static std::atomic<unsigned int> dropped{0};
+
+private:
+    enum class EventType : uint8_t {
+        BEGIN,
+        END,
+        FRAME
+    };
+
+    struct Event {
+        const char *name;
+        uint64_t time; // Nanoseconds since the first event
+        EventType type;
+        uint32_t thread;
+    };
+
+    // Single writer, the owning thread, and single reader, collect
+    struct Ring {
+        std::vector<Event> events;
+        std::atomic<size_t> head{0}; // Written up to, by the owner
+        std::atomic<size_t> tail{0}; // Read up to, by collect
+        uint32_t thread;
+        int depth = 0;               // Zones open, owner only
+    };
+
+    static Ring &ring();
+
+    // Needs room for the event and the ends of all zones it leaves open
+    static bool push(Ring &ring, const char *name, EventType type, size_t reserve);
+
+    static uint64_t now();
+
+    static void collect();
+
+    inline static std::mutex mutex; // Guards rings and store
+    inline static std::vector<std::unique_ptr<Ring>> rings;
+    inline static std::vector<Event> store;
+    inline static thread_local Ring *threadRing = nullptr;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char *name) : recorded(Profiler::begin(name)) {}
+
+    ~ProfileScope() {
+        if (this->recorded) Profiler::end();
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    bool recorded;
+};
+
+}
+
+#endif // GL_PROFILER_H
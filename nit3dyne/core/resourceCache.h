@@ -4,39 +4,122 @@
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <future>
 #include <iostream>
+#include <exception>
+
+#include "nit3dyne/core/loader.h"
 
 namespace n3d {
 
+/*
+ * Async loads require T to split construction in two:
+ *   static std::unique_ptr<T::Source> T::decode(const std::string &) - file I/O and decoding, any thread
+ *   T(const std::string &, T::Source &) - GL upload, render thread
+ */
 template <class T> class ResourceCache {
 public:
     ResourceCache();
     ~ResourceCache();
 
     std::shared_ptr<T> loadResource(const std::string &resourceName);
+    std::shared_future<std::shared_ptr<T>> loadResourceAsync(const std::string &resourceName);
     void sweep();
     void dbg();
 
 private:
+    // Moves finished async loads into resources
+    void collect();
+
     std::unordered_map<std::string, std::shared_ptr<T>> resources;
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<T>>> pending;
 };
 
 template <class T> ResourceCache<T>::ResourceCache() = default;
 template <class T> ResourceCache<T>::~ResourceCache() = default;
 
 template <class T> std::shared_ptr<T> ResourceCache<T>::loadResource(const std::string &resourceName) {
+    this->collect();
+
     auto found = this->resources.find(resourceName);
 
     if (found != this->resources.end())
         return found->second;
 
+    auto inFlight = this->pending.find(resourceName);
+    // If the async load failed, collect() drops it and the retry loads synchronously
+    if (inFlight != this->pending.end()) {
+        Loader::wait(inFlight->second);
+        return this->loadResource(resourceName);
+    }
+
     std::cout << "Resource cache miss: " << resourceName << std::endl;
     this->resources.emplace(resourceName, std::make_shared<T>(resourceName));
 
     return this->loadResource(resourceName);
 }
 
+template <class T>
+std::shared_future<std::shared_ptr<T>> ResourceCache<T>::loadResourceAsync(const std::string &resourceName) {
+    this->collect();
+
+    auto promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+
+    auto found = this->resources.find(resourceName);
+    if (found != this->resources.end()) {
+        promise->set_value(found->second);
+        return promise->get_future().share();
+    }
+
+    auto inFlight = this->pending.find(resourceName);
+    if (inFlight != this->pending.end())
+        return inFlight->second;
+
+    std::cout << "Resource cache miss (async): " << resourceName << std::endl;
+    auto future = promise->get_future().share();
+    this->pending.emplace(resourceName, future);
+
+    // A job dropped on shutdown destroys its promise, collect() sees that as a failed load
+    Loader::submit([resourceName, promise]() {
+        try {
+            std::shared_ptr<typename T::Source> source = T::decode(resourceName);
+
+            Loader::queueUpload([resourceName, promise, source]() {
+                try {
+                    promise->set_value(std::make_shared<T>(resourceName, *source));
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+
+    return future;
+}
+
+template <class T> void ResourceCache<T>::collect() {
+    for (auto pendingIter = this->pending.begin(); pendingIter != this->pending.end();) {
+        if (pendingIter->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            try {
+                this->resources.emplace(pendingIter->first, pendingIter->second.get());
+            } catch (const std::exception &e) {
+                std::cout << "Resource cache error: failed to load " << pendingIter->first << ": " << e.what()
+                          << std::endl;
+            } catch (...) {
+                std::cout << "Resource cache error: failed to load " << pendingIter->first << std::endl;
+            }
+            pendingIter = this->pending.erase(pendingIter);
+        } else {
+            pendingIter++;
+        }
+    }
+}
+
 template <class T> void ResourceCache<T>::sweep() {
+    this->collect();
+
     for (auto resourceIter = this->resources.cbegin(); resourceIter != this->resources.cend();) {
         if (resourceIter->second.use_count() < 2)
             resourceIter = this->resources.erase(resourceIter);
@@ -46,6 +129,8 @@ template <class T> void ResourceCache<T>::sweep() {
 }
 
 template <class T> void ResourceCache<T>::dbg() {
+    this->collect();
+
     std::cout << "Resource cache contents:" << std::endl;
     if (!this->resources.empty())
         for (auto &resource : this->resources) {
@@ -53,6 +138,9 @@ template <class T> void ResourceCache<T>::dbg() {
         }
     else
         std::cout << "\tEmpty" << std::endl;
+
+    if (!this->pending.empty())
+        std::cout << "\t" << this->pending.size() << " loading" << std::endl;
 }
 
 }
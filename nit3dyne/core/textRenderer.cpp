@@ -0,0 +1,231 @@
+#include "textRenderer.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace n3d {
+
+const char *FONT_FILE = "font";
+const unsigned int FONT_WIDTH = 5;
+const unsigned int FONT_HEIGHT = 8;
+const unsigned int FONT_WIDTHS[95] = {
+        // SPACE !"#%&'()*+,-./
+        5,
+        1,
+        3,
+        5,
+        5,
+        5,
+        5,
+        1,
+        2,
+        2,
+        3,
+        3,
+        2,
+        3,
+        1,
+        4,
+        // 0 - 9
+        4,
+        3,
+        4,
+        4,
+        4,
+        4,
+        4,
+        4,
+        4,
+        4,
+        // :;<=>?@
+        1,
+        1,
+        4,
+        4,
+        4,
+        4,
+        5,
+        // A - Z
+        4,
+        4,
+        4,
+        4,
+        4,
+        4,
+        4,
+        4,
+        3,
+        5,
+        4,
+        4,
+        5,
+        5,
+        4,
+        4,
+        5,
+        4,
+        4,
+        5,
+        4,
+        5,
+        5,
+        5,
+        5,
+        5,
+        // [\]^_`
+        2,
+        4,
+        2,
+        3,
+        5,
+        2,
+        // a - z
+        4,
+        4,
+        4,
+        4,
+        4,
+        2,
+        4,
+        4,
+        1,
+        2,
+        3,
+        2,
+        5,
+        4,
+        4,
+        4,
+        4,
+        3,
+        4,
+        3,
+        4,
+        3,
+        5,
+        5,
+        4,
+        4,
+        // {|}~
+        2,
+        1,
+        2,
+        5};
+
+// Gap between glyphs and distance between lines, in glyph heights
+const float FONT_SPACING = .3f;
+const float FONT_LINE_HEIGHT = 1.3f;
+
+void TextRenderer::init() {
+    atlas = new Texture(FONT_FILE);
+
+    shader = new Shader("shaders/font.vert", "shaders/font.frag");
+    shader->use();
+    shader->setUniform("tex", 0);
+
+    stream = new StreamBuffer(GL_ARRAY_BUFFER, 1 << 18);
+
+    glGenVertexArrays(1, &VAO);
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, stream->getHandle());
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *) offsetof(TextVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *) offsetof(TextVertex, uv));
+
+    GLState::bindVertexArray(0);
+}
+
+void TextRenderer::destroy() {
+    GLState::deleteVertexArrays(1, &VAO);
+    delete stream;
+    delete shader;
+    delete atlas;
+
+    batch.clear();
+    clearCache();
+}
+
+void TextRenderer::text(const std::string &str, const vec2 &position, float scale, bool cached) {
+    if (!cached) {
+        scratch.clear();
+        layout(str, scratch);
+        append(scratch, position, scale);
+        return;
+    }
+
+    size_t hash = std::hash<std::string>()(str);
+    auto found = layouts.find(hash);
+    if (found == layouts.end()) {
+        found = layouts.emplace(hash, Layout{str, {}}).first;
+        layout(str, found->second.vertices);
+    } else if (found->second.str != str) {
+        // Hash collision, lay this one out every time
+        scratch.clear();
+        layout(str, scratch);
+        append(scratch, position, scale);
+        return;
+    }
+
+    append(found->second.vertices, position, scale);
+}
+
+void TextRenderer::layout(const std::string &str, std::vector<TextVertex> &out) {
+    float u = 1.f / (float) atlas->w;
+    float v = (float) FONT_HEIGHT / (float) atlas->h;
+    float x = 0.f, y = 0.f;
+
+    for (char c : str) {
+        if (c == '\n') {
+            x = 0.f;
+            y -= FONT_LINE_HEIGHT;
+            continue;
+        }
+        if (c < ' ' || c > '~') continue;
+
+        int charIdx = c - ' ';
+        float charWidth = (1.f / FONT_WIDTH) * FONT_WIDTHS[charIdx];
+        float u0 = (float) (charIdx * FONT_WIDTH) * u;
+        float u1 = (float) (charIdx * FONT_WIDTH + FONT_WIDTHS[charIdx]) * u;
+
+        // Atlas rows run top down, the top of the glyph is v = 0
+        TextVertex tl{vec2(x, y + 1.f), vec2(u0, 0.f)};
+        TextVertex bl{vec2(x, y), vec2(u0, v)};
+        TextVertex tr{vec2(x + charWidth, y + 1.f), vec2(u1, 0.f)};
+        TextVertex br{vec2(x + charWidth, y), vec2(u1, v)};
+        out.insert(out.end(), {tl, bl, tr, tr, bl, br});
+
+        x += charWidth + FONT_SPACING;
+    }
+}
+
+void TextRenderer::append(const std::vector<TextVertex> &vertices, const vec2 &position, float scale) {
+    for (const TextVertex &vertex : vertices)
+        batch.push_back({position + vertex.position * scale, vertex.uv});
+}
+
+void TextRenderer::draw() {
+    glyphs = (unsigned int) (batch.size() / 6);
+    if (batch.empty()) return;
+
+    // Aligned to the vertex size so the offset is a whole first vertex
+    auto span = stream->allocate<TextVertex>(batch.size(), sizeof(TextVertex));
+    if (span) {
+        std::copy(batch.begin(), batch.end(), span.begin());
+        stream->commit();
+
+        shader->use();
+        GLState::bindTexture(GL_TEXTURE_2D, atlas->handle);
+        GLState::bindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, (GLint) (span.offset / sizeof(TextVertex)), (GLsizei) batch.size());
+    }
+
+    batch.clear();
+}
+
+void TextRenderer::clearCache() {
+    layouts.clear();
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef GL_TEXT_RENDERER_H
+#define GL_TEXT_RENDERER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/graphics/gl_state.h"
+#include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/stream_buffer.h"
+#include "nit3dyne/graphics/texture.h"
+
+namespace n3d {
+
+struct TextVertex {
+    vec2 position; // Font units, one glyph high, see shaders/font.vert
+    vec2 uv;
+};
+
+/*
+ * All text on screen in one draw. Strings queued during the frame are laid out from the bitmap
+ * font's glyph widths, streamed into a ring and drawn from the shared atlas by draw().
+ * Strings that do not change can be queued cached, their layout is kept by hash and only moved.
+ */
+class TextRenderer {
+public:
+    static void init();
+
+    static void destroy();
+
+    // Newlines start a new line below, characters outside printable ASCII are skipped
+    static void text(const std::string &str, const vec2 &position, float scale = 1.f, bool cached = false);
+
+    static void draw();
+
+    static void clearCache();
+
+    // Glyphs drawn by the last draw
+    inline static unsigned int glyphs = 0;
+
+private:
+    struct Layout {
+        std::string str;
+        std::vector<TextVertex> vertices;
+    };
+
+    // Appends the string's quads at the origin, unscaled
+    static void layout(const std::string &str, std::vector<TextVertex> &out);
+
+    static void append(const std::vector<TextVertex> &vertices, const vec2 &position, float scale);
+
+    inline static std::vector<TextVertex> batch;
+    inline static std::vector<TextVertex> scratch;
+    inline static std::unordered_map<size_t, Layout> layouts;
+
+    inline static Texture *atlas;
+    inline static Shader *shader;
+    inline static StreamBuffer *stream;
+    inline static unsigned int VAO;
+};
+
+}
+
+#endif // GL_TEXT_RENDERER_H
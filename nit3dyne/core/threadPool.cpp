@@ -0,0 +1,93 @@
+#include "threadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace n3d {
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        unsigned int hw = std::thread::hardware_concurrency();
+        threads = hw > 1 ? hw - 1 : 1;
+    }
+
+    for (size_t i = 0; i < threads; ++i)
+        this->workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->available.notify_all();
+
+    for (auto &worker : this->workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->jobs.push_back(std::move(job));
+    }
+    this->available.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &job) {
+    if (count == 0) return;
+
+    // Helpers may start after every index is taken, even after return, so they share the state
+    struct State {
+        const std::function<void(size_t)> *job;
+        size_t count;
+        std::atomic<size_t> next{0};
+        size_t finished = 0;
+        std::mutex latch;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<State>();
+    state->job = &job;
+    state->count = count;
+
+    auto run = [](State &state) {
+        size_t ran = 0;
+        for (size_t i = state.next++; i < state.count; i = state.next++, ++ran)
+            (*state.job)(i);
+        if (ran == 0) return;
+
+        std::lock_guard<std::mutex> lock(state.latch);
+        state.finished += ran;
+        if (state.finished == state.count) state.done.notify_one();
+    };
+
+    size_t helpers = std::min(count - 1, this->workers.size());
+    for (size_t i = 0; i < helpers; ++i)
+        this->submit([state, run]() { run(*state); });
+
+    // Taking indices here too means busy workers slow the loop down but never stall it
+    run(*state);
+
+    std::unique_lock<std::mutex> lock(state->latch);
+    state->done.wait(lock, [&state]() { return state->finished == state->count; });
+}
+
+void ThreadPool::work() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->available.wait(lock, [this] { return this->stopping || !this->jobs.empty(); });
+
+            // Queued jobs are dropped on shutdown
+            if (this->stopping) return;
+
+            job = std::move(this->jobs.front());
+            this->jobs.pop_front();
+        }
+        job();
+    }
+}
+
+}
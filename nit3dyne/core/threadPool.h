@@ -0,0 +1,43 @@
+#ifndef GL_THREAD_POOL_H
+#define GL_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace n3d {
+
+class ThreadPool {
+public:
+    // 0 picks one worker per hardware thread, minus one for the render thread
+    explicit ThreadPool(size_t threads = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(std::function<void()> job);
+
+    // Runs job for every index and returns when all are done. The caller takes indices too, so a pool busy
+    // with other jobs, or a call from one of its own jobs, runs the loop on fewer threads instead of waiting.
+    void parallelFor(size_t count, const std::function<void(size_t)> &job);
+
+    size_t size() const { return this->workers.size(); }
+
+private:
+    void work();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping = false;
+};
+
+}
+
+#endif // GL_THREAD_POOL_H
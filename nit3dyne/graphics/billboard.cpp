@@ -19,32 +19,32 @@ Billboard::Billboard(std::pair<float, float> &&size, const std::shared_ptr<Textu
 }
 
 Billboard::~Billboard() {
-    glDeleteVertexArrays(1, &this->VAO);
+    GLState::deleteVertexArrays(1, &this->VAO);
 }
 
 void Billboard::draw(n3d::Shader &shader) {
     shader.use();
+    shader.setUniform("position", this->position);
+    shader.setUniform("size", this->size);
+    shader.setUniform("viewScale", this->viewScale);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, this->texture->handle);
+    GLState::bindTexture(GL_TEXTURE_2D, this->texture->handle);
 
-    glBindVertexArray(this->VAO);
+    GLState::bindVertexArray(this->VAO);
     glDrawArrays(
         GL_TRIANGLES,
         0,
         6
     );
-
-    glBindVertexArray(0);
 }
 
 void Billboard::bind() {
     glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
+    GLState::bindVertexArray(this->VAO);
 
     unsigned int VBO;
     glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
 
     glBufferData(
             GL_ARRAY_BUFFER,
@@ -62,8 +62,8 @@ void Billboard::bind() {
             (void *) 0
     );
 
-    glBindVertexArray(0);
-    glDeleteBuffers(1, &VBO);
+    GLState::bindVertexArray(0);
+    GLState::deleteBuffers(1, &VBO);
 }
 
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "nit3dyne/core/math.h"
 #include "nit3dyne/graphics/shader.h"
 #include "nit3dyne/graphics/texture.h"
+#include "nit3dyne/graphics/gl_state.h"
 
 
 namespace n3d {
@@ -0,0 +1,175 @@
+#include "billboard_batch.h"
+
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+#include "nit3dyne/graphics/frame_uniforms.h"
+
+namespace n3d {
+
+// 1x1 quad, same as Billboard
+static const float BILLBOARD_QUAD[] = {
+    -.5f, .5f,
+    -.5f, -.5f,
+    .5f, -.5f,
+    -.5f, .5f,
+    .5f, -.5f,
+    .5f, .5f,
+};
+
+// Maps a float to a key that sorts the same way as unsigned
+static uint32_t sortableFloat(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+BillboardBatch::BillboardBatch() {
+    glGenVertexArrays(1, &this->VAO);
+    GLState::bindVertexArray(this->VAO);
+
+    glGenBuffers(1, &this->quadVbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(BILLBOARD_QUAD), BILLBOARD_QUAD, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void *) 0);
+
+    glGenBuffers(1, &this->instanceVbo);
+    for (unsigned int location = 1; location <= 4; ++location) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    GLState::bindVertexArray(0);
+}
+
+BillboardBatch::~BillboardBatch() {
+    GLState::deleteVertexArrays(1, &this->VAO);
+    GLState::deleteBuffers(1, &this->quadVbo);
+    GLState::deleteBuffers(1, &this->instanceVbo);
+}
+
+void BillboardBatch::add(Texture &texture, const vec3 &position, const vec2 &size, const vec4 &uvRect,
+                         const vec4 &color, bool transparent) {
+    Entry entry{&texture, {position, size, uvRect, color}};
+    if (transparent)
+        this->transparent.push_back(entry);
+    else
+        this->opaque.push_back(entry);
+}
+
+void BillboardBatch::clear() {
+    this->opaque.clear();
+    this->transparent.clear();
+}
+
+void BillboardBatch::draw(Shader &shader) {
+    this->draws = 0;
+    if (this->opaque.empty() && this->transparent.empty()) return;
+
+    shader.use();
+    GLState::bindVertexArray(this->VAO);
+
+    // Opaque, grouped by texture so each texture is one call
+    if (!this->opaque.empty()) {
+        std::unordered_map<const Texture *, uint32_t> slots;
+        this->keys.resize(this->opaque.size());
+        for (size_t i = 0; i < this->opaque.size(); ++i)
+            this->keys[i] = slots.emplace(this->opaque[i].texture, slots.size()).first->second;
+        this->radixSort();
+
+        this->drawEntries(shader, this->opaque, alphaCutoff);
+    }
+
+    // Transparent, back to front by view depth
+    if (!this->transparent.empty()) {
+        const mat4 &view = FrameUniforms::frame.view;
+        this->keys.resize(this->transparent.size());
+        for (size_t i = 0; i < this->transparent.size(); ++i) {
+            float depth = -(view * vec4(this->transparent[i].instance.position, 1.f)).z;
+            this->keys[i] = ~sortableFloat(depth);
+        }
+        this->radixSort();
+
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::depthMask(false);
+
+        this->drawEntries(shader, this->transparent, 0.f);
+
+        GLState::depthMask(true);
+    }
+
+    this->clear();
+}
+
+void BillboardBatch::drawEntries(Shader &shader, const std::vector<Entry> &entries, float cutoff) {
+    shader.setUniform("alphaCutoff", cutoff);
+
+    this->staging.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+        this->staging[i] = entries[this->order[i]].instance;
+
+    // Orphan and refill, the previous frame's draws may still be reading the old storage
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->instanceVbo);
+    if (entries.size() > this->capacity)
+        this->capacity = entries.size() * 2;
+    glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(BillboardInstance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, entries.size() * sizeof(BillboardInstance), this->staging.data());
+
+    size_t first = 0;
+    while (first < entries.size()) {
+        const Texture *texture = entries[this->order[first]].texture;
+        size_t last = first + 1;
+        while (last < entries.size() && entries[this->order[last]].texture == texture)
+            ++last;
+
+        GLState::bindTexture(GL_TEXTURE_2D, texture->handle);
+        this->setInstanceOffset(first);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, last - first);
+        ++this->draws;
+
+        first = last;
+    }
+}
+
+void BillboardBatch::setInstanceOffset(size_t first) {
+    size_t base = first * sizeof(BillboardInstance);
+    GLsizei stride = sizeof(BillboardInstance);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                          (void *) (base + offsetof(BillboardInstance, position)));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                          (void *) (base + offsetof(BillboardInstance, size)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride,
+                          (void *) (base + offsetof(BillboardInstance, uvRect)));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride,
+                          (void *) (base + offsetof(BillboardInstance, color)));
+}
+
+void BillboardBatch::radixSort() {
+    size_t count = this->keys.size();
+    this->order.resize(count);
+    this->scratch.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        this->order[i] = i;
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t offsets[257] = {};
+        for (size_t i = 0; i < count; ++i)
+            ++offsets[((this->keys[this->order[i]] >> shift) & 0xFF) + 1];
+
+        // Every key has the same byte, nothing to do
+        if (offsets[((this->keys[this->order[0]] >> shift) & 0xFF) + 1] == count) continue;
+
+        for (int bucket = 0; bucket < 256; ++bucket)
+            offsets[bucket + 1] += offsets[bucket];
+        for (size_t i = 0; i < count; ++i)
+            this->scratch[offsets[(this->keys[this->order[i]] >> shift) & 0xFF]++] = this->order[i];
+
+        std::swap(this->order, this->scratch);
+    }
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef GL_BILLBOARD_BATCH_H
+#define GL_BILLBOARD_BATCH_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/texture.h"
+#include "nit3dyne/graphics/gl_state.h"
+
+namespace n3d {
+
+// Per-instance attributes at locations 1-4
+struct BillboardInstance {
+    vec3 position;
+    vec2 size;
+    vec4 uvRect; // Offset and extent in texture space
+    vec4 color;
+};
+
+/*
+ * Camera facing quads gathered over a frame and drawn with one instanced call per texture.
+ * Opaque billboards are alpha tested, transparent ones are blended and sorted back to front,
+ * so they are drawn as runs of the same texture. Use with billboard-instanced.vert/.frag.
+ */
+class BillboardBatch {
+public:
+    // Fragments below this alpha are discarded in the opaque pass
+    inline static float alphaCutoff = .5f;
+
+    BillboardBatch();
+
+    ~BillboardBatch();
+
+    void add(Texture &texture, const vec3 &position, const vec2 &size,
+             const vec4 &uvRect = vec4(0.f, 0.f, 1.f, 1.f), const vec4 &color = vec4(1.f),
+             bool transparent = false);
+
+    // Draws and empties the batch, camera comes from FrameData
+    void draw(Shader &shader);
+
+    void clear();
+
+    // Instanced calls issued by the last draw
+    unsigned int draws = 0;
+
+private:
+    struct Entry {
+        Texture *texture;
+        BillboardInstance instance;
+    };
+
+    // Streams entries in order through the instance buffer, one call per run of the same texture.
+    // Fragments below cutoff alpha are discarded, zero keeps all.
+    void drawEntries(Shader &shader, const std::vector<Entry> &entries, float cutoff);
+
+    // Points the instance attributes at the given first instance, GL 3.3 has no base instance
+    void setInstanceOffset(size_t first);
+
+    // Stable LSD radix sort of entry indices by keys into order
+    void radixSort();
+
+    std::vector<Entry> opaque;
+    std::vector<Entry> transparent;
+
+    // Scratch for sorting and staging, kept to avoid reallocating each frame
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> scratch;
+    std::vector<BillboardInstance> staging;
+
+    unsigned int VAO = 0;
+    unsigned int quadVbo = 0;
+    unsigned int instanceVbo = 0;
+    size_t capacity = 0;
+};
+
+}
+
+#endif // GL_BILLBOARD_BATCH_H
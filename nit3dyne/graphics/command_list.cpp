@@ -0,0 +1,53 @@
+#include "command_list.h"
+
+#include "nit3dyne/graphics/mesh_animated.h"
+
+namespace n3d {
+
+void CommandList::begin(const mat4 &perspective, const mat4 &view) {
+    this->perspective = perspective;
+    this->view = view;
+    this->frustum = Frustum(perspective * view);
+    this->clear();
+}
+
+void CommandList::record(Shader &shader, const Material &material, Texture *texture, Mesh &mesh,
+                         const mat4 &modelMat, int lod, RenderPass pass) {
+    if (!this->frustum.containsBounds(mesh.boundsMin, mesh.boundsMax, mesh.sphereCenter, mesh.sphereRadius,
+                                      modelMat)) {
+        ++this->culled;
+        return;
+    }
+
+    if (mesh.meshType == MeshType::COLORED) texture = nullptr;
+
+    DrawItem item{&shader, &material, texture, &mesh, lod, pass};
+    item.modelView = this->view * modelMat;
+    item.mvp = this->perspective * item.modelView;
+    item.normalMat = inverse(transpose(mat3(item.modelView)));
+    item.distance = glm::length(vec3(item.modelView[3]));
+    transformAabb(mesh.boundsMin, mesh.boundsMax, modelMat, item.worldMin, item.worldMax);
+
+    item.jointOffset = (uint32_t) this->joints.size();
+    item.jointCount = 0;
+    if (mesh.meshType == MeshType::ANIMATED) {
+        static_cast<MeshAnimated &>(mesh).pose(this->pose);
+        this->joints.insert(this->joints.end(), this->pose.begin(), this->pose.end());
+        item.jointCount = (uint32_t) this->pose.size();
+    }
+
+    this->items.push_back(item);
+}
+
+void CommandList::clear() {
+    this->items.clear();
+    this->joints.clear();
+    this->culled = 0;
+}
+
+const mat4 *CommandList::getJoints(const DrawItem &item) const {
+    if (item.jointCount == 0) return nullptr;
+    return this->joints.data() + item.jointOffset;
+}
+
+}
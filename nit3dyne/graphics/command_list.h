@@ -0,0 +1,80 @@
+#ifndef GL_COMMAND_LIST_H
+#define GL_COMMAND_LIST_H
+
+#include <cstdint>
+#include <vector>
+
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/camera/frustum.h"
+#include "nit3dyne/graphics/material.h"
+#include "nit3dyne/graphics/mesh.h"
+#include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/texture.h"
+
+namespace n3d {
+
+enum RenderPass {
+    PASS_OPAQUE,
+    PASS_TRANSPARENT,
+    PASS_OVERLAY
+};
+
+// One draw with everything the GL thread needs precomputed
+struct DrawItem {
+    Shader *shader;
+    const Material *material;
+    Texture *texture; // Unused for colored meshes
+    Mesh *mesh;
+    int lod;
+    RenderPass pass;
+    mat4 mvp;
+    mat4 modelView;
+    mat3 normalMat;
+    float distance;     // From the camera, for sorting
+    vec3 worldMin;      // World bounds, for occlusion tests on the GL thread
+    vec3 worldMax;
+    uint32_t jointOffset; // Palette in the list's joint arena, animated meshes only
+    uint32_t jointCount;
+};
+
+/*
+ * Draws recorded without touching GL, so lists can be filled on worker threads, one list per thread.
+ * Recording culls against the frustum, computes the matrices and poses animated meshes.
+ * RenderQueue::merge hands a finished list to the GL thread; the list must stay untouched until
+ * the queue is flushed.
+ */
+class CommandList {
+public:
+    // Camera for the recording, every list merged into a queue must use the queue's camera
+    void begin(const mat4 &perspective, const mat4 &view);
+
+    // Animated meshes advance their animation here, record each of them on one list only
+    void record(Shader &shader, const Material &material, Texture *texture, Mesh &mesh, const mat4 &modelMat,
+                int lod = 0, RenderPass pass = PASS_OPAQUE);
+
+    // Empties the list, keeping the camera
+    void clear();
+
+    const std::vector<DrawItem> &getItems() const { return this->items; }
+
+    const mat4 *getJoints(const DrawItem &item) const;
+
+    const mat4 &getPerspective() const { return this->perspective; }
+
+    const mat4 &getView() const { return this->view; }
+
+    unsigned int culled = 0; // Recordings since begin that were outside the frustum
+
+private:
+    mat4 perspective = mat4(1.f);
+    mat4 view = mat4(1.f);
+    Frustum frustum;
+
+    std::vector<DrawItem> items;
+    std::vector<mat4> joints;
+    std::vector<mat4> pose; // Scratch for posing
+};
+
+}
+
+#endif // GL_COMMAND_LIST_H
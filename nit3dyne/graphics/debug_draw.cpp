@@ -0,0 +1,163 @@
+#include "debug_draw.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "nit3dyne/graphics/frame_uniforms.h"
+
+namespace n3d {
+
+void DebugDraw::init() {
+    shader = new Shader("shaders/line.vert", "shaders/line.frag");
+    stream = new StreamBuffer(GL_ARRAY_BUFFER, 1 << 20);
+
+    // Attributes point at the start of the ring, draws select their range with the first vertex
+    glGenVertexArrays(1, &VAO);
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, stream->getHandle());
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void *) offsetof(DebugVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void *) offsetof(DebugVertex, color));
+
+    GLState::bindVertexArray(0);
+}
+
+void DebugDraw::destroy() {
+    GLState::deleteVertexArrays(1, &VAO);
+    delete stream;
+    delete shader;
+    clear();
+}
+
+void DebugDraw::line(const vec3 &start, const vec3 &end, const vec3 &color, DebugLayer layer) {
+    if (!enabled) return;
+    layers[layer].push_back({start, color});
+    layers[layer].push_back({end, color});
+}
+
+void DebugDraw::box(const vec3 &min, const vec3 &max, const vec3 &color, DebugLayer layer) {
+    if (!enabled) return;
+
+    vec3 points[8];
+    for (int i = 0; i < 8; ++i)
+        points[i] = vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+    corners(points, color, layer);
+}
+
+void DebugDraw::box(const vec3 &min, const vec3 &max, const mat4 &modelMat, const vec3 &color, DebugLayer layer) {
+    if (!enabled) return;
+
+    vec3 points[8];
+    for (int i = 0; i < 8; ++i) {
+        vec3 local(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        points[i] = vec3(modelMat * vec4(local, 1.f));
+    }
+    corners(points, color, layer);
+}
+
+void DebugDraw::sphere(const vec3 &center, float radius, const vec3 &color, DebugLayer layer, int segments) {
+    if (!enabled) return;
+    segments = std::max(segments, 3);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        // Circle in the plane of the other two axes
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        vec3 previous = center;
+        previous[u] += radius;
+
+        for (int i = 1; i <= segments; ++i) {
+            float angle = 2.f * (float) M_PI * (float) i / (float) segments;
+            vec3 point = center;
+            point[u] += radius * std::cos(angle);
+            point[v] += radius * std::sin(angle);
+
+            line(previous, point, color, layer);
+            previous = point;
+        }
+    }
+}
+
+void DebugDraw::frustum(const mat4 &viewProjection, const vec3 &color, DebugLayer layer) {
+    if (!enabled) return;
+
+    mat4 inverseViewProjection = inverse(viewProjection);
+    vec3 points[8];
+    for (int i = 0; i < 8; ++i) {
+        vec4 ndc(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f, 1.f);
+        vec4 world = inverseViewProjection * ndc;
+        points[i] = vec3(world) / world.w;
+    }
+    corners(points, color, layer);
+}
+
+void DebugDraw::skeleton(const Skin &skin, const mat4 &modelMat, const vec3 &color, DebugLayer layer) {
+    if (!enabled) return;
+
+    // Same space as Joint::getJointMatrix, the skin's global transform is removed
+    mat4 toWorld = modelMat * inverse(skin.globalTransform);
+    for (const auto &pJoint : skin.joints) {
+        const Joint &joint = pJoint.second;
+        vec3 start = vec3(toWorld * joint.globalJointTransform[3]);
+        for (const Joint *child : joint.children)
+            line(start, vec3(toWorld * child->globalJointTransform[3]), color, layer);
+    }
+}
+
+void DebugDraw::corners(const vec3 points[8], const vec3 &color, DebugLayer layer) {
+    // Every corner to the corners one bit away
+    for (int i = 0; i < 8; ++i) {
+        for (int bit = 1; bit < 8; bit <<= 1) {
+            if (!(i & bit)) line(points[i], points[i | bit], color, layer);
+        }
+    }
+}
+
+void DebugDraw::draw() {
+    size_t total = 0;
+    for (auto &layer : layers)
+        total += layer.size();
+
+    vertices = (unsigned int) total;
+    if (total == 0) return;
+
+    // Aligned to the vertex size so the offset is a whole first vertex
+    auto span = stream->allocate<DebugVertex>(total, sizeof(DebugVertex));
+    if (!span) {
+        clear();
+        return;
+    }
+
+    size_t written = 0;
+    for (auto &layer : layers) {
+        std::copy(layer.begin(), layer.end(), span.begin() + written);
+        written += layer.size();
+    }
+    stream->commit();
+
+    shader->use();
+    shader->setUniform("mvp", FrameUniforms::frame.viewProjection);
+    GLState::bindVertexArray(VAO);
+
+    GLint first = (GLint) (span.offset / sizeof(DebugVertex));
+    for (int layer = 0; layer < DEBUG_LAYER_COUNT; ++layer) {
+        GLsizei count = (GLsizei) layers[layer].size();
+        if (count == 0) continue;
+
+        if (layer == DEBUG_OVERLAY) GLState::disable(GL_DEPTH_TEST);
+        glDrawArrays(GL_LINES, first, count);
+        if (layer == DEBUG_OVERLAY) GLState::enable(GL_DEPTH_TEST);
+
+        first += count;
+    }
+
+    clear();
+}
+
+void DebugDraw::clear() {
+    for (auto &layer : layers)
+        layer.clear();
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef GL_DEBUG_DRAW_H
+#define GL_DEBUG_DRAW_H
+
+#include <vector>
+
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/animation/skin.h"
+#include "nit3dyne/graphics/gl_state.h"
+#include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/stream_buffer.h"
+
+namespace n3d {
+
+enum DebugLayer {
+    DEBUG_DEPTH,   // Hidden behind scene geometry
+    DEBUG_OVERLAY, // Drawn over everything
+    DEBUG_LAYER_COUNT
+};
+
+// Same layout as one end of a Line, so the line shader draws both
+struct DebugVertex {
+    vec3 position;
+    vec3 color;
+};
+
+/*
+ * Immediate mode debug lines in world space. Calls append to a CPU list for the frame;
+ * draw() streams every layer into one ring allocation and issues one GL_LINES call per layer.
+ */
+class DebugDraw {
+public:
+    // Calls are dropped while disabled
+    inline static bool enabled = true;
+
+    static void init();
+
+    static void destroy();
+
+    static void line(const vec3 &start, const vec3 &end, const vec3 &color, DebugLayer layer = DEBUG_DEPTH);
+
+    static void box(const vec3 &min, const vec3 &max, const vec3 &color, DebugLayer layer = DEBUG_DEPTH);
+
+    // Local box under modelMat, e.g. mesh bounds
+    static void box(const vec3 &min, const vec3 &max, const mat4 &modelMat, const vec3 &color,
+                    DebugLayer layer = DEBUG_DEPTH);
+
+    // Three great circles
+    static void sphere(const vec3 &center, float radius, const vec3 &color, DebugLayer layer = DEBUG_DEPTH,
+                       int segments = 16);
+
+    // Edges of the volume a view projection matrix sees
+    static void frustum(const mat4 &viewProjection, const vec3 &color, DebugLayer layer = DEBUG_DEPTH);
+
+    // Bone from every joint to each child in the current pose
+    static void skeleton(const Skin &skin, const mat4 &modelMat, const vec3 &color,
+                         DebugLayer layer = DEBUG_OVERLAY);
+
+    // Draws everything added since the last draw with the frame's camera, then clears
+    static void draw();
+
+    static void clear();
+
+    // Line vertices sent by the last draw
+    inline static unsigned int vertices = 0;
+
+private:
+    // Corners indexed by bits, x = 1, y = 2, z = 4
+    static void corners(const vec3 points[8], const vec3 &color, DebugLayer layer);
+
+    inline static std::vector<DebugVertex> layers[DEBUG_LAYER_COUNT];
+
+    inline static Shader *shader;
+    inline static StreamBuffer *stream;
+    inline static unsigned int VAO;
+};
+
+}
+
+#endif // GL_DEBUG_DRAW_H
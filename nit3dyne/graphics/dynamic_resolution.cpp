@@ -0,0 +1,39 @@
+#include "dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace n3d {
+
+// Weight of a new measurement in the smoothed GPU time
+const double GPU_TIME_SMOOTHING = .2;
+
+float DynamicResolution::update(const GpuTimer &timer) {
+    // Only the latest of several new frames counts, the timer's own history holds the rest
+    const GpuTimer::Stats *frame = timer.stats("frame");
+    bool measured = frame != nullptr && frame->samples != this->samples;
+    if (measured) {
+        this->samples = frame->samples;
+        this->gpuTime = this->gpuTime == 0. ? frame->last
+                                            : this->gpuTime + (frame->last - this->gpuTime) * GPU_TIME_SMOOTHING;
+    }
+
+    if (!measured || this->gpuTime <= 0.) {
+        this->scale = std::min(std::max(this->scale, this->minScale), this->maxScale);
+        return this->scale;
+    }
+
+    // The smoothed time was taken at about the current scale
+    float ideal = this->scale * (float) std::sqrt(this->targetTime / this->gpuTime);
+    ideal = std::min(std::max(ideal, this->minScale), this->maxScale);
+
+    // Small moves are skipped, except towards a bound the scale should settle at
+    bool bound = ideal == this->minScale || ideal == this->maxScale;
+    if (bound || std::abs(ideal - this->scale) >= this->threshold)
+        this->scale += (ideal - this->scale) * this->response;
+
+    this->scale = std::min(std::max(this->scale, this->minScale), this->maxScale);
+    return this->scale;
+}
+
+}
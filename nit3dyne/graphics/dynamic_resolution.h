@@ -0,0 +1,41 @@
+#ifndef GL_DYNAMIC_RESOLUTION_H
+#define GL_DYNAMIC_RESOLUTION_H
+
+#include "nit3dyne/graphics/gpu_timer.h"
+
+namespace n3d {
+
+/*
+ * Picks the render scale from the GPU frame time measured by a GpuTimer, which arrives a few
+ * frames late but never stalls. Pixel cost is taken as proportional to the scale squared.
+ */
+class DynamicResolution {
+public:
+    // GPU time per frame to hold, in seconds, below the frame budget to leave room for the swap
+    double targetTime = 1. / 75. * .85;
+
+    // Bounds of the scale, a share of the allocated render size on both axes
+    float minScale = .5f;
+    float maxScale = 1.f;
+
+    // Share of the distance to the ideal scale moved per measurement, and the smallest move made
+    float response = .25f;
+    float threshold = .02f;
+
+    // Takes the timer's new frame measurements and returns the scale for the next frame
+    float update(const GpuTimer &timer);
+
+    float getScale() const { return this->scale; }
+
+    // Smoothed, in seconds, zero until the first measurement arrives
+    double getGpuTime() const { return this->gpuTime; }
+
+private:
+    size_t samples = 0; // Frame measurements taken from the timer so far
+    double gpuTime = 0.;
+    float scale = 1.f;
+};
+
+}
+
+#endif // GL_DYNAMIC_RESOLUTION_H
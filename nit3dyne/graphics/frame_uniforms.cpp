@@ -0,0 +1,75 @@
+#include "frame_uniforms.h"
+
+#include "nit3dyne/core/display.h"
+
+namespace n3d {
+
+void FrameUniforms::init() {
+    glGenBuffers(1, &frameUbo);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, BINDING_FRAME, frameUbo);
+
+    glGenBuffers(1, &lightUbo);
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, lightUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightData), nullptr, GL_DYNAMIC_DRAW);
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, BINDING_LIGHTS, lightUbo);
+
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    stream = new StreamBuffer(GL_UNIFORM_BUFFER, streamSize);
+
+    setDirectionalLight(DirectionalLight());
+    setSpotLight(SpotLight());
+}
+
+void FrameUniforms::destroy() {
+    GLState::deleteBuffers(1, &frameUbo);
+    GLState::deleteBuffers(1, &lightUbo);
+
+    delete stream;
+    stream = nullptr;
+}
+
+void FrameUniforms::setDirectionalLight(const DirectionalLight &dLight) {
+    lights.dLightDirection = dLight.direction;
+    lights.dLightAmbient = vec4(dLight.ambient, 0.f);
+    lights.dLightDiffuse = vec4(dLight.diffuse, 0.f);
+    lights.dLightSpecular = vec4(dLight.specular, 0.f);
+    lightsDirty = true;
+}
+
+void FrameUniforms::setSpotLight(const SpotLight &sLight) {
+    lights.sLightPosition = sLight.position;
+    lights.sLightDirection = sLight.direction;
+    lights.sLightCutOff = sLight.cutOff;
+    lightsDirty = true;
+}
+
+void FrameUniforms::setLightClusters(const vec4 &grid, const vec4 &depth) {
+    lights.clusterGrid = grid;
+    lights.clusterDepth = depth;
+    lightsDirty = true;
+}
+
+void FrameUniforms::update(Camera &camera) {
+    frame.projection = camera.projection;
+    frame.view = camera.getView();
+    frame.viewProjection = frame.projection * frame.view;
+    frame.cameraPosition = vec4(camera.position, 1.f);
+
+    float w = Display::viewPortVirtual.first, h = Display::viewPortVirtual.second;
+    frame.viewPort = vec4(w, h, 1.f / w, 1.f / h);
+    frame.time = vec4(Display::time, Display::timeDelta, Display::frame, 0.f);
+
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frame);
+
+    if (lightsDirty) {
+        GLState::bindBuffer(GL_UNIFORM_BUFFER, lightUbo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightData), &lights);
+        lightsDirty = false;
+    }
+}
+
+}
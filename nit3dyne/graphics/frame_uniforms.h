@@ -0,0 +1,93 @@
+#ifndef GL_FRAME_UNIFORMS_H
+#define GL_FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+
+#include "nit3dyne/camera/camera.h"
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/graphics/lighting.h"
+#include "nit3dyne/graphics/stream_buffer.h"
+#include "nit3dyne/graphics/gl_state.h"
+
+namespace n3d {
+
+// Fixed uniform block binding points, shaders are bound to them at link
+enum UniformBinding {
+    BINDING_FRAME = 0,
+    BINDING_LIGHTS = 1,
+    BINDING_JOINTS = 2
+};
+
+// Fixed texture units of the clustered light buffers, see graphics/light_clusters.h
+enum TextureBinding {
+    UNIT_LIGHTS = 13,
+    UNIT_LIGHT_CLUSTERS = 14,
+    UNIT_LIGHT_INDICES = 15
+};
+
+// Size of the JointPalette block in shaders/vertex-skinned.vert
+const int MAX_JOINTS = 25;
+
+// std140 mirrors of the blocks in shaders/include/uniforms.glsl, vec3 members are padded to vec4
+struct FrameData {
+    mat4 projection;
+    mat4 view;
+    mat4 viewProjection;
+    vec4 cameraPosition; // World space
+    vec4 viewPort;       // Virtual width, height and their reciprocals
+    vec4 time;           // Seconds, frame delta, frame number
+};
+
+struct LightData {
+    vec4 dLightDirection;
+    vec4 dLightAmbient;
+    vec4 dLightDiffuse;
+    vec4 dLightSpecular;
+    vec4 sLightPosition;
+    vec4 sLightDirection;
+    float sLightCutOff;
+    float padding[3];
+    vec4 clusterGrid;  // Tiles x, y, depth slices, clustered lights
+    vec4 clusterDepth; // Scale and bias of the log depth slicing
+};
+
+static_assert(sizeof(FrameData) == 240, "FrameData does not match the std140 block");
+static_assert(sizeof(LightData) == 144, "LightData does not match the std140 block");
+
+/*
+ * Camera and light state shared by every shader through uniform buffers.
+ * Lights are kept until changed, the blocks are written once per frame by update().
+ */
+class FrameUniforms {
+public:
+    static void init();
+
+    static void destroy();
+
+    // Lights are in view space, like the loose uniforms they replace
+    static void setDirectionalLight(const DirectionalLight &dLight);
+
+    static void setSpotLight(const SpotLight &sLight);
+
+    // Set by LightClusters::update
+    static void setLightClusters(const vec4 &grid, const vec4 &depth);
+
+    // Writes the frame block for the camera, and the light block if a light changed
+    static void update(Camera &camera);
+
+    inline static FrameData frame;
+    inline static LightData lights;
+
+    // Ring for per-draw uniform data such as joint palettes, bind ranges of it with GLState::bindBufferRange
+    inline static StreamBuffer *stream;
+    inline static size_t streamSize = 1 << 18;
+
+private:
+    inline static unsigned int frameUbo;
+    inline static unsigned int lightUbo;
+    inline static bool lightsDirty;
+};
+
+}
+
+#endif // GL_FRAME_UNIFORMS_H
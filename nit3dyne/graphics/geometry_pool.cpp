@@ -0,0 +1,242 @@
+#include "geometry_pool.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "nit3dyne/graphics/terrain.h"
+
+namespace n3d {
+
+VertexLayout vertexLayout(MeshType meshType) {
+    switch (meshType) {
+        case COLORED:
+            return LAYOUT_COLORED;
+        case ANIMATED:
+            return LAYOUT_ANIMATED;
+        case STATIC:
+        default:
+            return LAYOUT_STATIC;
+    }
+}
+
+RangeAllocator::RangeAllocator(uint32_t capacity) {
+    if (capacity > 0)
+        this->freeRanges.emplace(0, capacity);
+}
+
+bool RangeAllocator::allocate(uint32_t size, uint32_t &offset) {
+    for (auto it = this->freeRanges.begin(); it != this->freeRanges.end(); ++it) {
+        if (it->second < size) continue;
+
+        offset = it->first;
+        uint32_t remaining = it->second - size;
+        this->freeRanges.erase(it);
+        if (remaining > 0)
+            this->freeRanges.emplace(offset + size, remaining);
+
+        return true;
+    }
+
+    return false;
+}
+
+void RangeAllocator::release(uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+
+    auto it = this->freeRanges.emplace(offset, size).first;
+
+    // Merge with the following range
+    auto next = std::next(it);
+    if (next != this->freeRanges.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        this->freeRanges.erase(next);
+    }
+
+    // Merge with the preceding range
+    if (it != this->freeRanges.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            this->freeRanges.erase(it);
+        }
+    }
+}
+
+unsigned int GeometryPool::stride(VertexLayout layout) {
+    switch (layout) {
+        case LAYOUT_COLORED:
+            return sizeof(VertexColored);
+        case LAYOUT_ANIMATED:
+            return sizeof(VertexAnimated);
+        case LAYOUT_TERRAIN:
+            return sizeof(TerrainVertex);
+        case LAYOUT_STATIC:
+        default:
+            return sizeof(VertexStatic);
+    }
+}
+
+GeometryRange GeometryPool::allocate(VertexLayout layout, uint32_t vertexCount, uint32_t indexCount) {
+    GeometryRange range;
+    range.layout = layout;
+    range.vertexCount = vertexCount;
+    range.indexCount = indexCount;
+
+    auto &layoutBlocks = blocks[layout];
+    for (size_t i = 0; i < layoutBlocks.size(); ++i) {
+        Block &block = layoutBlocks[i];
+        if (!block.vertices.allocate(vertexCount, range.baseVertex)) continue;
+        if (!block.indices.allocate(indexCount, range.firstIndex)) {
+            block.vertices.release(range.baseVertex, vertexCount);
+            continue;
+        }
+
+        range.block = i;
+        return range;
+    }
+
+    // No room left, oversized geometry gets a block of its own
+    range.block = createBlock(
+            layout, std::max(vertexCount, blockVertices), std::max(indexCount, blockIndices)
+    );
+    Block &block = layoutBlocks[range.block];
+    block.vertices.allocate(vertexCount, range.baseVertex);
+    block.indices.allocate(indexCount, range.firstIndex);
+
+    return range;
+}
+
+void GeometryPool::upload(const GeometryRange &range, const void *vertices, const void *indices) {
+    if (!range.valid()) return;
+    const Block &block = blocks[range.layout][range.block];
+    unsigned int vertexStride = stride(range.layout);
+
+    // Element buffer binding is VAO state, bind the owning VAO so no other VAO is modified
+    GLState::bindVertexArray(block.VAO);
+
+    GLState::bindBuffer(GL_ARRAY_BUFFER, block.VBO);
+    glBufferSubData(
+            GL_ARRAY_BUFFER,
+            (GLintptr) range.baseVertex * vertexStride,
+            (GLsizeiptr) range.vertexCount * vertexStride,
+            vertices
+    );
+
+    glBufferSubData(
+            GL_ELEMENT_ARRAY_BUFFER,
+            (GLintptr) range.firstIndex * sizeof(uint32_t),
+            (GLsizeiptr) range.indexCount * sizeof(uint32_t),
+            indices
+    );
+
+    GLState::bindVertexArray(0);
+}
+
+void GeometryPool::free(GeometryRange &range) {
+    if (!range.valid()) return;
+
+    // Pool may already be torn down at shutdown
+    auto &layoutBlocks = blocks[range.layout];
+    if ((size_t) range.block < layoutBlocks.size()) {
+        Block &block = layoutBlocks[range.block];
+        block.vertices.release(range.baseVertex, range.vertexCount);
+        block.indices.release(range.firstIndex, range.indexCount);
+    }
+
+    range.block = -1;
+}
+
+void GeometryPool::bind(const GeometryRange &range) {
+    GLState::bindVertexArray(blocks[range.layout][range.block].VAO);
+}
+
+void GeometryPool::attach(const GeometryRange &range) {
+    const Block &block = blocks[range.layout][range.block];
+    GLState::bindBuffer(GL_ARRAY_BUFFER, block.VBO);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, block.EBO);
+    setupLayout(range.layout);
+}
+
+void GeometryPool::destroy() {
+    for (auto &layoutBlocks : blocks) {
+        for (Block &block : layoutBlocks) {
+            GLState::deleteVertexArrays(1, &block.VAO);
+            GLState::deleteBuffers(1, &block.VBO);
+            GLState::deleteBuffers(1, &block.EBO);
+        }
+        layoutBlocks.clear();
+    }
+}
+
+int GeometryPool::createBlock(VertexLayout layout, uint32_t vertexCapacity, uint32_t indexCapacity) {
+    Block block{0, 0, 0, RangeAllocator(vertexCapacity), RangeAllocator(indexCapacity)};
+
+    glGenVertexArrays(1, &block.VAO);
+    GLState::bindVertexArray(block.VAO);
+
+    glGenBuffers(1, &block.VBO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, block.VBO);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) vertexCapacity * stride(layout), nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &block.EBO);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, block.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) indexCapacity * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+    setupLayout(layout);
+    GLState::bindVertexArray(0);
+
+    std::cout << "Geometry pool: new block for layout " << layout << ", " << vertexCapacity << " vertices, "
+              << indexCapacity << " indices" << std::endl;
+
+    blocks[layout].push_back(block);
+    return blocks[layout].size() - 1;
+}
+
+void GeometryPool::setupLayout(VertexLayout layout) {
+    int vertexStride = stride(layout);
+
+    switch (layout) {
+        case LAYOUT_STATIC:
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexStatic, position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexStatic, normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexStatic, uv));
+            break;
+        case LAYOUT_COLORED:
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexColored, position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexColored, normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexColored, color));
+            break;
+        case LAYOUT_ANIMATED:
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexAnimated, position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexAnimated, normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexAnimated, uv));
+            glEnableVertexAttribArray(3);
+            glVertexAttribIPointer(3, 4, GL_UNSIGNED_SHORT, vertexStride, (void *) offsetof(VertexAnimated, joints));
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(VertexAnimated, weights));
+            break;
+        case LAYOUT_TERRAIN:
+            glEnableVertexAttribArray(0); // POS
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(TerrainVertex, vertex));
+            glEnableVertexAttribArray(1); // NORMAL
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(TerrainVertex, normal));
+            glEnableVertexAttribArray(2); // TEXT
+            glVertexAttribIPointer(2, 1, GL_INT, vertexStride, (void *) offsetof(TerrainVertex, texture));
+            glEnableVertexAttribArray(3); // UV
+            glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, vertexStride, (void *) offsetof(TerrainVertex, uv));
+            break;
+        default:
+            break;
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+#ifndef GL_GEOMETRY_POOL_H
+#define GL_GEOMETRY_POOL_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "nit3dyne/graphics/mesh_data.h"
+#include "nit3dyne/graphics/gl_state.h"
+
+namespace n3d {
+
+enum VertexLayout {
+    LAYOUT_STATIC,
+    LAYOUT_COLORED,
+    LAYOUT_ANIMATED,
+    LAYOUT_TERRAIN,
+    LAYOUT_COUNT
+};
+
+VertexLayout vertexLayout(MeshType meshType);
+
+// First-fit free list over [0, capacity), adjacent free ranges are merged on release
+class RangeAllocator {
+public:
+    explicit RangeAllocator(uint32_t capacity);
+
+    bool allocate(uint32_t size, uint32_t &offset);
+
+    void release(uint32_t offset, uint32_t size);
+
+private:
+    std::map<uint32_t, uint32_t> freeRanges; // offset -> size
+};
+
+// Sub-allocation in one of the pool's blocks, offsets are in vertices and indices
+struct GeometryRange {
+    VertexLayout layout = LAYOUT_STATIC;
+    int block = -1;
+    uint32_t baseVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+
+    bool valid() const { return this->block >= 0; }
+};
+
+/*
+ * Shared vertex and index buffers, a few large blocks per vertex layout, each with one VAO.
+ * Geometry lives as ranges in a block and is drawn with the base vertex variants of glDrawElements.
+ */
+class GeometryPool {
+public:
+    inline static uint32_t blockVertices = 1 << 18;
+    inline static uint32_t blockIndices = 1 << 20;
+
+    static GeometryRange allocate(VertexLayout layout, uint32_t vertexCount, uint32_t indexCount);
+
+    static void upload(const GeometryRange &range, const void *vertices, const void *indices);
+
+    static void free(GeometryRange &range);
+
+    // Binds the VAO of the block the range lives in
+    static void bind(const GeometryRange &range);
+
+    // Points the currently bound VAO at the range's block and sets up its layout, for VAOs with extra attributes
+    static void attach(const GeometryRange &range);
+
+    static void destroy();
+
+    static unsigned int stride(VertexLayout layout);
+
+private:
+    struct Block {
+        unsigned int VAO;
+        unsigned int VBO;
+        unsigned int EBO;
+        RangeAllocator vertices;
+        RangeAllocator indices;
+    };
+
+    static int createBlock(VertexLayout layout, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+    static void setupLayout(VertexLayout layout);
+
+    inline static std::vector<Block> blocks[LAYOUT_COUNT];
+};
+
+}
+
+#endif // GL_GEOMETRY_POOL_H
@@ -0,0 +1,216 @@
+#include "gl_state.h"
+
+#include <algorithm>
+
+namespace n3d {
+
+void GLState::invalidate() {
+    program = UNKNOWN;
+    vao = UNKNOWN;
+    std::fill(buffers, buffers + BUFFER_TARGET_COUNT, UNKNOWN);
+    for (auto &unit : textures)
+        std::fill(unit, unit + TEXTURE_TARGET_COUNT, UNKNOWN);
+    activeUnit = UNKNOWN;
+    framebuffer = UNKNOWN;
+    std::fill(viewPort, viewPort + 4, -1);
+    depthWrite = UNKNOWN;
+    depthFunction = UNKNOWN;
+    blendSource = UNKNOWN;
+    blendDestination = UNKNOWN;
+    capabilities.clear();
+}
+
+int GLState::bufferTarget(GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER: return BUFFER_ARRAY;
+        case GL_UNIFORM_BUFFER: return BUFFER_UNIFORM;
+        case GL_TEXTURE_BUFFER: return BUFFER_TEXTURE;
+        case GL_COPY_READ_BUFFER: return BUFFER_COPY_READ;
+        case GL_COPY_WRITE_BUFFER: return BUFFER_COPY_WRITE;
+        case GL_PIXEL_PACK_BUFFER: return BUFFER_PIXEL_PACK;
+        case GL_PIXEL_UNPACK_BUFFER: return BUFFER_PIXEL_UNPACK;
+        default: return -1;
+    }
+}
+
+int GLState::textureTarget(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D: return TEXTURE_2D;
+        case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+        case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+        case GL_TEXTURE_3D: return TEXTURE_3D;
+        case GL_TEXTURE_BUFFER: return TEXTURE_BUFFER;
+        default: return -1;
+    }
+}
+
+void GLState::useProgram(GLuint program) {
+    if (change(GLState::program, program)) glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (change(GLState::vao, vao)) glBindVertexArray(vao);
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    int index = bufferTarget(target);
+    if (index < 0) {
+        ++issued;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (change(buffers[index], buffer)) glBindBuffer(target, buffer);
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    // Indexed bindings are not shadowed, they are set rarely and mostly once
+    ++issued;
+    glBindBufferBase(target, index, buffer);
+
+    int generic = bufferTarget(target);
+    if (generic >= 0) buffers[generic] = buffer;
+}
+
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    ++issued;
+    glBindBufferRange(target, index, buffer, offset, size);
+
+    int generic = bufferTarget(target);
+    if (generic >= 0) buffers[generic] = buffer;
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture, GLuint unit) {
+    int index = textureTarget(target);
+    if (index < 0 || unit >= MAX_TEXTURE_UNITS) {
+        if (change(activeUnit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+        ++issued;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (textures[unit][index] == texture) {
+        ++filtered;
+        return;
+    }
+
+    if (change(activeUnit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+    change(textures[unit][index], texture);
+    glBindTexture(target, texture);
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer) {
+    if (change(GLState::framebuffer, framebuffer)) glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState::bindFramebuffers(GLuint read, GLuint draw) {
+    issued += 2;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw);
+    framebuffer = read == draw ? read : UNKNOWN;
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (viewPort[0] == x && viewPort[1] == y && viewPort[2] == width && viewPort[3] == height) {
+        ++filtered;
+        return;
+    }
+
+    viewPort[0] = x;
+    viewPort[1] = y;
+    viewPort[2] = width;
+    viewPort[3] = height;
+    ++issued;
+    glViewport(x, y, width, height);
+}
+
+void GLState::setCapability(GLenum capability, bool enabled) {
+    auto known = capabilities.find(capability);
+    if (known != capabilities.end() && known->second == enabled) {
+        ++filtered;
+        return;
+    }
+
+    capabilities[capability] = enabled;
+    ++issued;
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+}
+
+void GLState::enable(GLenum capability) {
+    setCapability(capability, true);
+}
+
+void GLState::disable(GLenum capability) {
+    setCapability(capability, false);
+}
+
+void GLState::depthMask(bool write) {
+    if (change(depthWrite, write)) glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (change(depthFunction, func)) glDepthFunc(func);
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+    if (blendSource == source && blendDestination == destination) {
+        ++filtered;
+        return;
+    }
+
+    blendSource = source;
+    blendDestination = destination;
+    ++issued;
+    glBlendFunc(source, destination);
+}
+
+void GLState::forget(GLuint &shadow, GLuint name) {
+    // GL falls back to 0 when a bound object is deleted
+    if (shadow == name) shadow = 0;
+}
+
+void GLState::deleteProgram(GLuint program) {
+    // A current program stays in use until replaced, only the name is released then
+    if (GLState::program == program) GLState::program = UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint *vaos) {
+    for (GLsizei i = 0; i < count; ++i)
+        forget(vao, vaos[i]);
+    glDeleteVertexArrays(count, vaos);
+}
+
+void GLState::deleteBuffers(GLsizei count, const GLuint *buffers) {
+    for (GLsizei i = 0; i < count; ++i) {
+        for (GLuint &bound : GLState::buffers)
+            forget(bound, buffers[i]);
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+void GLState::deleteTextures(GLsizei count, const GLuint *textures) {
+    for (GLsizei i = 0; i < count; ++i) {
+        for (auto &unit : GLState::textures) {
+            for (GLuint &bound : unit)
+                forget(bound, textures[i]);
+        }
+    }
+    glDeleteTextures(count, textures);
+}
+
+void GLState::deleteFramebuffers(GLsizei count, const GLuint *framebuffers) {
+    for (GLsizei i = 0; i < count; ++i)
+        forget(framebuffer, framebuffers[i]);
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+void GLState::resetCounters() {
+    issued = 0;
+    filtered = 0;
+}
+
+}
@@ -0,0 +1,130 @@
+#ifndef GL_GL_STATE_H
+#define GL_GL_STATE_H
+
+#include <glad/glad.h>
+#include <unordered_map>
+
+namespace n3d {
+
+/*
+ * Shadow copy of the GL state the engine touches. Binds and state changes that match the
+ * shadow are dropped. Everything in the engine goes through here; code that calls GL directly
+ * must call invalidate() afterwards.
+ * The element array binding is VAO state, so it is always issued.
+ */
+class GLState {
+public:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    // Forgets the shadow, the next call of every kind is issued. Display::init starts from here.
+    static void invalidate();
+
+    static void useProgram(GLuint program);
+
+    static void bindVertexArray(GLuint vao);
+
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    // Also replaces the generic binding of target, like GL does
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    // Switches the active unit only when the bind is issued
+    static void bindTexture(GLenum target, GLuint texture, GLuint unit = 0);
+
+    static void bindFramebuffer(GLuint framebuffer);
+
+    // Separate read and draw bindings for blits, the combined binding is unknown until the next bind
+    static void bindFramebuffers(GLuint read, GLuint draw);
+
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    static void enable(GLenum capability);
+
+    static void disable(GLenum capability);
+
+    static void depthMask(bool write);
+
+    static void depthFunc(GLenum func);
+
+    static void blendFunc(GLenum source, GLenum destination);
+
+    // Deleted names can be reused by GL, they are dropped from the shadow
+    static void deleteProgram(GLuint program);
+
+    static void deleteVertexArrays(GLsizei count, const GLuint *vaos);
+
+    static void deleteBuffers(GLsizei count, const GLuint *buffers);
+
+    static void deleteTextures(GLsizei count, const GLuint *textures);
+
+    static void deleteFramebuffers(GLsizei count, const GLuint *framebuffers);
+
+    static void resetCounters();
+
+    // Calls passed on to GL and calls dropped as redundant since resetCounters
+    inline static unsigned int issued = 0;
+    inline static unsigned int filtered = 0;
+
+private:
+    enum BufferTarget {
+        BUFFER_ARRAY,
+        BUFFER_UNIFORM,
+        BUFFER_TEXTURE,
+        BUFFER_COPY_READ,
+        BUFFER_COPY_WRITE,
+        BUFFER_PIXEL_PACK,
+        BUFFER_PIXEL_UNPACK,
+        BUFFER_TARGET_COUNT
+    };
+
+    enum TextureTarget {
+        TEXTURE_2D,
+        TEXTURE_CUBE_MAP,
+        TEXTURE_2D_ARRAY,
+        TEXTURE_3D,
+        TEXTURE_BUFFER,
+        TEXTURE_TARGET_COUNT
+    };
+
+    // Index into the shadow, -1 for targets that are not tracked
+    static int bufferTarget(GLenum target);
+
+    static int textureTarget(GLenum target);
+
+    // Shadow value of anything GL may hold that the engine has not set
+    inline static const GLuint UNKNOWN = 0xffffffff;
+
+    // Compares and stores, true if the call is needed
+    static bool change(GLuint &shadow, GLuint value) {
+        if (shadow == value) {
+            ++filtered;
+            return false;
+        }
+        shadow = value;
+        ++issued;
+        return true;
+    }
+
+    static void forget(GLuint &shadow, GLuint name);
+
+    static void setCapability(GLenum capability, bool enabled);
+
+    inline static GLuint program = UNKNOWN;
+    inline static GLuint vao = UNKNOWN;
+    inline static GLuint buffers[BUFFER_TARGET_COUNT];
+    inline static GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+    inline static GLuint activeUnit = UNKNOWN;
+    inline static GLuint framebuffer = UNKNOWN;
+    inline static GLint viewPort[4];
+    inline static GLuint depthWrite = UNKNOWN;
+    inline static GLuint depthFunction = UNKNOWN;
+    inline static GLuint blendSource = UNKNOWN;
+    inline static GLuint blendDestination = UNKNOWN;
+    inline static std::unordered_map<GLenum, bool> capabilities; // Missing entries are unknown
+};
+
+}
+
+#endif // GL_GL_STATE_H
@@ -0,0 +1,170 @@
+#include "gpu_timer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace n3d {
+
+// Queries made at once when the pool runs dry
+const GLsizei QUERY_BATCH = 16;
+
+GpuTimer::GpuTimer() {
+    this->pass("frame");
+}
+
+GpuTimer::~GpuTimer() {
+    if (!this->queries.empty()) glDeleteQueries((GLsizei) this->queries.size(), this->queries.data());
+}
+
+int GpuTimer::pass(const std::string &name) {
+    auto found = this->passes.find(name);
+    if (found != this->passes.end()) return found->second;
+
+    int index = (int) this->histories.size();
+    this->histories.push_back({name, std::vector<double>(std::max<size_t>(this->historySize, 1), 0.), {}});
+    this->passes[name] = index;
+    this->totals.push_back(-1.);
+    return index;
+}
+
+unsigned int GpuTimer::query() {
+    if (this->freeQueries.empty()) {
+        unsigned int made[QUERY_BATCH];
+        glGenQueries(QUERY_BATCH, made);
+        this->freeQueries.insert(this->freeQueries.end(), made, made + QUERY_BATCH);
+        this->queries.insert(this->queries.end(), made, made + QUERY_BATCH);
+    }
+
+    unsigned int out = this->freeQueries.back();
+    this->freeQueries.pop_back();
+    return out;
+}
+
+void GpuTimer::beginFrame() {
+    if (this->timing) this->endFrame();
+    this->collect();
+
+    // Every frame still in flight, this one goes unmeasured rather than waiting
+    if (this->pending == FRAME_LATENCY) return;
+
+    this->timing = true;
+    this->begin("frame");
+}
+
+void GpuTimer::endFrame() {
+    if (!this->timing) return;
+
+    // The frame's own end is issued last, once it is available the whole frame is
+    Frame &frame = this->frames[(this->oldest + this->pending) % FRAME_LATENCY];
+    for (size_t i = frame.intervals.size(); i-- > 1;) {
+        if (frame.intervals[i].end == 0) {
+            frame.intervals[i].end = this->query();
+            glQueryCounter(frame.intervals[i].end, GL_TIMESTAMP);
+        }
+    }
+    this->end("frame");
+
+    this->timing = false;
+    ++this->pending;
+}
+
+void GpuTimer::begin(const std::string &pass) {
+    if (!this->timing) return;
+
+    Frame &frame = this->frames[(this->oldest + this->pending) % FRAME_LATENCY];
+    Interval interval{this->pass(pass), this->query(), 0};
+    glQueryCounter(interval.start, GL_TIMESTAMP);
+    frame.intervals.push_back(interval);
+}
+
+void GpuTimer::end(const std::string &pass) {
+    if (!this->timing) return;
+
+    auto found = this->passes.find(pass);
+    if (found == this->passes.end()) return;
+
+    // The innermost open interval of the pass
+    Frame &frame = this->frames[(this->oldest + this->pending) % FRAME_LATENCY];
+    for (auto interval = frame.intervals.rbegin(); interval != frame.intervals.rend(); ++interval) {
+        if (interval->pass != found->second || interval->end != 0) continue;
+        interval->end = this->query();
+        glQueryCounter(interval->end, GL_TIMESTAMP);
+        return;
+    }
+}
+
+void GpuTimer::collect() {
+    while (this->pending > 0) {
+        Frame &frame = this->frames[this->oldest];
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(frame.intervals.front().end, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) break;
+
+        for (const Interval &interval : frame.intervals) {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(interval.start, GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(interval.end, GL_QUERY_RESULT, &end);
+
+            double &total = this->totals[interval.pass];
+            total = std::max(total, 0.) + (double) (end - start) * 1e-9;
+
+            this->freeQueries.push_back(interval.start);
+            this->freeQueries.push_back(interval.end);
+        }
+        frame.intervals.clear();
+
+        for (size_t pass = 0; pass < this->totals.size(); ++pass) {
+            if (this->totals[pass] < 0.) continue;
+            this->record((int) pass, this->totals[pass]);
+            this->totals[pass] = -1.;
+        }
+
+        this->oldest = (this->oldest + 1) % FRAME_LATENCY;
+        --this->pending;
+    }
+}
+
+void GpuTimer::record(int pass, double seconds) {
+    History &history = this->histories[pass];
+    Stats &stats = history.stats;
+    history.samples[stats.samples % history.samples.size()] = seconds;
+    ++stats.samples;
+
+    size_t count = std::min(stats.samples, history.samples.size());
+    stats.last = seconds;
+    stats.min = seconds;
+    stats.max = seconds;
+    double sum = 0.;
+    for (size_t i = 0; i < count; ++i) {
+        sum += history.samples[i];
+        stats.min = std::min(stats.min, history.samples[i]);
+        stats.max = std::max(stats.max, history.samples[i]);
+    }
+    stats.mean = sum / (double) count;
+}
+
+const GpuTimer::Stats *GpuTimer::stats(const std::string &pass) const {
+    auto found = this->passes.find(pass);
+    if (found == this->passes.end()) return nullptr;
+
+    const Stats &stats = this->histories[found->second].stats;
+    return stats.samples > 0 ? &stats : nullptr;
+}
+
+void GpuTimer::print() const {
+    std::ios format(nullptr);
+    format.copyfmt(std::cout);
+
+    std::cout << std::fixed << std::setprecision(3);
+    for (const History &history : this->histories) {
+        const Stats &stats = history.stats;
+        if (stats.samples == 0) continue;
+        std::cout << "GPU " << history.name << ": " << stats.mean * 1e3 << " ms mean, " << stats.min * 1e3
+                  << " min, " << stats.max * 1e3 << " max" << std::endl;
+    }
+    std::cout.copyfmt(format);
+}
+
+}
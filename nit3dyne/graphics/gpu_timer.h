@@ -0,0 +1,96 @@
+#ifndef GL_GPU_TIMER_H
+#define GL_GPU_TIMER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace n3d {
+
+/*
+ * GPU time of named passes from GL_TIMESTAMP queries, so passes may nest. Queries come from a
+ * pool and stay in flight for up to FRAME_LATENCY frames; beginFrame() reads back only frames
+ * whose queries are available, and a frame starting with all of them in flight goes unmeasured,
+ * so the CPU never waits on the GPU. Every frame is also timed as the pass "frame".
+ */
+class GpuTimer {
+public:
+    static const int FRAME_LATENCY = 4;
+
+    // Over the last historySize measurements, in seconds
+    struct Stats {
+        double last;
+        double mean;
+        double min;
+        double max;
+        size_t samples; // Measurements ever taken
+    };
+
+    // Measurements per pass kept for the statistics, read when a pass is first timed
+    size_t historySize = 120;
+
+    GpuTimer();
+
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    // Reads back finished frames and starts timing a new one
+    void beginFrame();
+
+    void endFrame();
+
+    // Passes may nest, a pass ending more than once a frame adds up
+    void begin(const std::string &pass);
+
+    void end(const std::string &pass);
+
+    // Null until the pass has a measurement
+    const Stats *stats(const std::string &pass) const;
+
+    // One line per pass
+    void print() const;
+
+private:
+    struct Interval {
+        int pass;
+        unsigned int start;
+        unsigned int end; // Zero while open
+    };
+
+    struct Frame {
+        std::vector<Interval> intervals;
+    };
+
+    struct History {
+        std::string name;
+        std::vector<double> samples; // Ring, written at samples count % size
+        Stats stats;
+    };
+
+    int pass(const std::string &name);
+
+    unsigned int query();
+
+    void collect();
+
+    void record(int pass, double seconds);
+
+    Frame frames[FRAME_LATENCY];
+    int oldest = 0; // Frames in flight are oldest, oldest + 1, ... in ring order
+    int pending = 0;
+    bool timing = false;
+
+    std::vector<unsigned int> freeQueries;
+    std::vector<unsigned int> queries; // Every query made, for deletion
+    std::vector<History> histories;
+    std::unordered_map<std::string, int> passes;
+    std::vector<double> totals; // Per pass, scratch for collect
+};
+
+}
+
+#endif // GL_GPU_TIMER_H
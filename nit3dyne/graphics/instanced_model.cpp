@@ -0,0 +1,100 @@
+#include "instanced_model.h"
+
+#include <cstddef>
+#include <iostream>
+
+namespace n3d {
+
+const unsigned int INSTANCE_MODEL_LOCATION = 5;
+const unsigned int INSTANCE_TINT_LOCATION = 9;
+
+InstancedModel::InstancedModel(std::shared_ptr<Mesh> mesh, std::shared_ptr<Texture> texture) :
+        mesh(mesh), texture(texture) {
+    if (this->mesh->meshType == MeshType::ANIMATED)
+        std::cout << "InstancedModel error: animated meshes cannot be instanced" << std::endl;
+}
+
+InstancedModel::~InstancedModel() {
+    GLState::deleteVertexArrays(1, &this->VAO);
+    GLState::deleteBuffers(1, &this->instanceVbo);
+}
+
+void InstancedModel::add(const mat4 &modelMat, const vec4 &tint) {
+    this->instances.push_back({modelMat, tint});
+    this->dirty = true;
+}
+
+void InstancedModel::set(size_t i, const mat4 &modelMat, const vec4 &tint) {
+    this->instances[i] = {modelMat, tint};
+    this->dirty = true;
+}
+
+void InstancedModel::clear() {
+    this->instances.clear();
+    this->dirty = true;
+}
+
+void InstancedModel::setMaterial(const Material &material) {
+    this->material = &material;
+}
+
+void InstancedModel::draw(Shader &shader) {
+    if (this->instances.empty() || this->mesh->meshType == MeshType::ANIMATED) return;
+    if (!this->mesh->getGeometry().valid()) return;
+
+    if (this->VAO == 0) this->bind();
+    if (this->dirty) this->upload();
+
+    shader.use();
+    shader.attachMaterial(*this->material);
+
+    if (this->mesh->meshType != MeshType::COLORED) {
+        GLState::bindTexture(GL_TEXTURE_2D, this->texture->handle);
+    }
+
+    this->mesh->drawInstanced(this->VAO, this->instances.size(), this->lod);
+}
+
+void InstancedModel::bind() {
+    glGenVertexArrays(1, &this->VAO);
+    GLState::bindVertexArray(this->VAO);
+
+    // Mesh attributes straight from the geometry pool, instance attributes from our own buffer
+    GeometryPool::attach(this->mesh->getGeometry());
+
+    glGenBuffers(1, &this->instanceVbo);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->instanceVbo);
+
+    for (unsigned int column = 0; column < 4; ++column) {
+        glEnableVertexAttribArray(INSTANCE_MODEL_LOCATION + column);
+        glVertexAttribPointer(
+                INSTANCE_MODEL_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                (void *) (offsetof(InstanceData, modelMat) + column * sizeof(vec4))
+        );
+        glVertexAttribDivisor(INSTANCE_MODEL_LOCATION + column, 1);
+    }
+
+    glEnableVertexAttribArray(INSTANCE_TINT_LOCATION);
+    glVertexAttribPointer(
+            INSTANCE_TINT_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+            (void *) offsetof(InstanceData, tint)
+    );
+    glVertexAttribDivisor(INSTANCE_TINT_LOCATION, 1);
+
+    GLState::bindVertexArray(0);
+}
+
+void InstancedModel::upload() {
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->instanceVbo);
+
+    size_t bytes = this->instances.size() * sizeof(InstanceData);
+    if (this->instances.size() > this->capacity) {
+        this->capacity = this->instances.size() * 2;
+        glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, this->instances.data());
+
+    this->dirty = false;
+}
+
+}
@@ -0,0 +1,66 @@
+#ifndef GL_INSTANCED_MODEL_H
+#define GL_INSTANCED_MODEL_H
+
+#include <glad/glad.h>
+#include <memory>
+#include <vector>
+
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/graphics/material.h"
+#include "nit3dyne/graphics/mesh.h"
+#include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/texture.h"
+#include "nit3dyne/graphics/gl_state.h"
+
+namespace n3d {
+
+// Per-instance vertex attributes, model matrix at locations 5-8 and tint at 9
+struct InstanceData {
+    mat4 modelMat;
+    vec4 tint;
+};
+
+/*
+ * Many copies of one static or colored mesh in a single instanced draw per packet.
+ * Transforms go to an instance buffer that is only re-uploaded after a change, camera comes from FrameData.
+ * Use with vertex-instanced.vert or vertex-colored-instanced.vert; instances should be uniformly scaled.
+ */
+class InstancedModel {
+public:
+    InstancedModel(std::shared_ptr<Mesh> mesh, std::shared_ptr<Texture> texture);
+
+    ~InstancedModel();
+
+    void add(const mat4 &modelMat, const vec4 &tint = vec4(1.f));
+
+    // Instance i was changed in place
+    void set(size_t i, const mat4 &modelMat, const vec4 &tint = vec4(1.f));
+
+    void clear();
+
+    void draw(Shader &shader);
+
+    void setMaterial(const Material &material);
+
+    size_t size() const { return this->instances.size(); }
+
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Texture> texture;
+    const Material *material = &Materials::basic;
+    int lod = 0;
+
+private:
+    void bind();
+
+    void upload();
+
+    std::vector<InstanceData> instances;
+    unsigned int VAO = 0;
+    unsigned int instanceVbo = 0;
+    size_t capacity = 0;
+    bool dirty = false;
+};
+
+}
+
+#endif // GL_INSTANCED_MODEL_H
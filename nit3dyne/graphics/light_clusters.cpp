@@ -0,0 +1,237 @@
+#include "light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "nit3dyne/graphics/frame_uniforms.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace n3d {
+
+// Attenuation below this share of the light's brightest channel is treated as dark
+const float LIGHT_THRESHOLD = 1.f / 256.f;
+
+static int lowestBit(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int) index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+void LightClusters::init() {
+    // Reads past the size limit are undefined, the light list takes five texels per light
+    GLint limit = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &limit);
+    maxIndices = (size_t) std::max(limit, 65536);
+    maxLights = std::min(maxLights, maxIndices / (sizeof(GpuLight) / sizeof(vec4)));
+
+    glGenBuffers(3, buffers);
+    glGenTextures(3, textures);
+
+    const GLenum formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R16UI};
+    const GLuint units[3] = {UNIT_LIGHTS, UNIT_LIGHT_CLUSTERS, UNIT_LIGHT_INDICES};
+    for (int i = 0; i < 3; ++i) {
+        // Never empty, a texture buffer without storage is incomplete
+        upload(buffers[i], nullptr, 16);
+        GLState::bindTexture(GL_TEXTURE_BUFFER, textures[i], units[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+}
+
+void LightClusters::destroy() {
+    GLState::deleteTextures(3, textures);
+    GLState::deleteBuffers(3, buffers);
+    clear();
+}
+
+LightClusters::GpuLight LightClusters::makeLight(const PointLight &light) {
+    GpuLight out;
+    out.position = vec4(vec3(light.position), attenuationRange(light));
+    out.ambient = vec4(light.ambient, -2.f);
+    out.diffuse = vec4(light.diffuse, light.constant);
+    out.specular = vec4(light.specular, light.linear);
+    out.direction = vec4(0.f, 0.f, 0.f, light.quadratic);
+    return out;
+}
+
+float LightClusters::attenuationRange(const PointLight &light) {
+    vec3 peak = max(max(light.ambient, light.diffuse), light.specular);
+    float brightest = std::max(std::max(peak.r, peak.g), peak.b);
+
+    // Distance where constant + linear * d + quadratic * d^2 reaches brightest / threshold
+    float c = light.constant - brightest / LIGHT_THRESHOLD;
+    if (light.quadratic > 0.f)
+        return (-light.linear + std::sqrt(light.linear * light.linear - 4.f * light.quadratic * c)) /
+               (2.f * light.quadratic);
+    if (light.linear > 0.f) return std::max(-c / light.linear, 0.f);
+    return farDepth;
+}
+
+void LightClusters::addPointLight(const PointLight &light) {
+    lights.push_back(makeLight(light));
+}
+
+void LightClusters::addSpotLight(const PointLight &light, const vec3 &direction, float cutOff) {
+    GpuLight spot = makeLight(light);
+    spot.ambient.w = cutOff;
+    spot.direction = vec4(normalize(direction), light.quadratic);
+    lights.push_back(spot);
+}
+
+void LightClusters::clear() {
+    lights.clear();
+}
+
+int LightClusters::tile(float ndc, int tiles) {
+    int t = (int) std::floor((ndc * .5f + .5f) * (float) tiles);
+    return std::min(std::max(t, 0), tiles - 1);
+}
+
+int LightClusters::slice(float depth) {
+    int z = (int) std::floor(std::log(depth) * sliceScale + sliceBias);
+    return std::min(std::max(z, 0), slices - 1);
+}
+
+void LightClusters::update(Camera &camera) {
+    const mat4 &projection = camera.projection;
+    mat4 view = camera.getView();
+
+    // Planes of a GL perspective projection
+    float nearDepth = projection[3][2] / (projection[2][2] - 1.f);
+    float lastDepth = std::min(projection[3][2] / (projection[2][2] + 1.f), farDepth);
+    sliceScale = (float) slices / std::log(lastDepth / nearDepth);
+    sliceBias = -std::log(nearDepth) * sliceScale;
+
+    viewLights.clear();
+    bounds.clear();
+    for (const GpuLight &light : lights) {
+        if (viewLights.size() >= maxLights) break;
+
+        vec3 center = vec3(view * vec4(vec3(light.position), 1.f));
+        float radius = light.position.w;
+        float depth = -center.z;
+        if (depth + radius < nearDepth) continue;
+
+        // Screen rect of the sphere's box, the whole screen once the box reaches the near plane
+        vec2 ndcMin(-1.f), ndcMax(1.f);
+        if (depth - radius > nearDepth) {
+            ndcMin = vec2(1.f);
+            ndcMax = vec2(-1.f);
+            for (int i = 0; i < 8; ++i) {
+                vec3 corner = center + radius * vec3(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f);
+                vec4 clip = projection * vec4(corner, 1.f);
+                vec2 ndc = vec2(clip) / clip.w;
+                ndcMin = min(ndcMin, ndc);
+                ndcMax = max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.f || ndcMax.y < -1.f || ndcMin.x > 1.f || ndcMin.y > 1.f) continue;
+        }
+
+        bounds.push_back({tile(ndcMin.x, tilesX), tile(ndcMax.x, tilesX),
+                          tile(ndcMin.y, tilesY), tile(ndcMax.y, tilesY),
+                          slice(std::max(depth - radius, nearDepth)), slice(depth + radius)});
+
+        GpuLight viewLight = light;
+        viewLight.position = vec4(center, radius);
+        viewLight.direction = vec4(vec3(view * vec4(vec3(light.direction), 0.f)), light.direction.w);
+        viewLights.push_back(viewLight);
+    }
+
+    bins.resize(slices);
+    Loader::parallelFor((size_t) slices, [](size_t z) { binSlice((int) z); });
+
+    // Slices are binned cluster by cluster, concatenating them keeps the table in cluster order
+    size_t clustersPerSlice = (size_t) tilesX * tilesY;
+    table.resize(clustersPerSlice * slices * 2);
+    // Clusters past the texture buffer size limit keep only the indices that still fit
+    indices.clear();
+    dropped = 0;
+    for (int z = 0; z < slices; ++z) {
+        const SliceBins &bin = bins[z];
+        auto source = bin.indices.begin();
+        for (size_t cluster = 0; cluster < clustersPerSlice; ++cluster) {
+            uint32_t count = bin.counts[cluster];
+            uint32_t kept = (uint32_t) std::min((size_t) count, maxIndices - indices.size());
+
+            size_t index = (z * clustersPerSlice + cluster) * 2;
+            table[index] = (uint32_t) indices.size();
+            table[index + 1] = kept;
+            indices.insert(indices.end(), source, source + kept);
+            source += count;
+            dropped += count - kept;
+        }
+    }
+
+    visible = (unsigned int) viewLights.size();
+    references = (unsigned int) indices.size();
+
+    upload(buffers[0], viewLights.data(), viewLights.size() * sizeof(GpuLight));
+    upload(buffers[1], table.data(), table.size() * sizeof(uint32_t));
+    upload(buffers[2], indices.data(), indices.size() * sizeof(uint16_t));
+
+    FrameUniforms::setLightClusters(vec4(tilesX, tilesY, slices, visible), vec4(sliceScale, sliceBias, 0.f, 0.f));
+}
+
+void LightClusters::binSlice(int z) {
+    SliceBins &bin = bins[z];
+
+    bin.candidates.clear();
+    for (uint32_t i = 0; i < (uint32_t) bounds.size(); ++i) {
+        if (bounds[i].minZ <= z && z <= bounds[i].maxZ) bin.candidates.push_back(i);
+    }
+
+    size_t clusters = (size_t) tilesX * tilesY;
+    bin.counts.assign(clusters, 0);
+    bin.indices.clear();
+    if (bin.candidates.empty()) return;
+
+    // A light is in a cluster when its bit is set in both the cluster's column and row,
+    // so each cluster tests 64 lights per AND
+    size_t words = (bin.candidates.size() + 63) / 64;
+    bin.columns.assign(tilesX * words, 0);
+    bin.rows.assign(tilesY * words, 0);
+    for (size_t k = 0; k < bin.candidates.size(); ++k) {
+        const Bounds &light = bounds[bin.candidates[k]];
+        uint64_t bit = uint64_t(1) << (k % 64);
+        for (int x = light.minX; x <= light.maxX; ++x)
+            bin.columns[x * words + k / 64] |= bit;
+        for (int y = light.minY; y <= light.maxY; ++y)
+            bin.rows[y * words + k / 64] |= bit;
+    }
+
+    for (int y = 0; y < tilesY; ++y) {
+        const uint64_t *row = &bin.rows[y * words];
+        for (int x = 0; x < tilesX; ++x) {
+            const uint64_t *column = &bin.columns[x * words];
+            size_t before = bin.indices.size();
+
+            for (size_t word = 0; word < words; ++word) {
+                uint64_t hits = column[word] & row[word];
+                while (hits) {
+                    bin.indices.push_back((uint16_t) bin.candidates[word * 64 + lowestBit(hits)]);
+                    hits &= hits - 1;
+                }
+            }
+
+            bin.counts[y * tilesX + x] = (uint32_t) (bin.indices.size() - before);
+        }
+    }
+}
+
+void LightClusters::upload(unsigned int buffer, const void *data, size_t bytes) {
+    // Orphans last frame's storage, the texture keeps pointing at the buffer
+    GLState::bindBuffer(GL_TEXTURE_BUFFER, buffer);
+    if (bytes == 0) {
+        glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+    } else {
+        glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr) bytes, data, GL_STREAM_DRAW);
+    }
+}
+
+}
@@ -0,0 +1,110 @@
+#ifndef GL_LIGHT_CLUSTERS_H
+#define GL_LIGHT_CLUSTERS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "nit3dyne/camera/camera.h"
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/core/loader.h"
+#include "nit3dyne/graphics/lighting.h"
+#include "nit3dyne/graphics/gl_state.h"
+
+namespace n3d {
+
+/*
+ * Clustered point and spot lights. The view is split in screen tiles and logarithmic depth slices;
+ * update() bins every light's bounding sphere into the clusters it touches, one slice per job on
+ * the Loader's worker threads, and uploads the lights, the per-cluster ranges and the light indices as texture
+ * buffers. Shaders including shaders/include/lights.glsl only loop over their vertex's cluster.
+ */
+class LightClusters {
+public:
+    // Grid size, read by init
+    inline static int tilesX = 16;
+    inline static int tilesY = 9;
+    inline static int slices = 24;
+
+    // Depth of the last slice's start, everything farther shares it
+    inline static float farDepth = 1000.f;
+
+    // Lights in view beyond this are dropped, indices are 16 bit. init clamps it to the texture buffer size limit.
+    inline static size_t maxLights = 65535;
+
+    // Binning runs on the Loader workers, init the Loader first
+    static void init();
+
+    static void destroy();
+
+    // World space, the range comes from the attenuation. Lights are kept until clear.
+    static void addPointLight(const PointLight &light);
+
+    // World space cone, cutOff is the cosine of the half angle
+    static void addSpotLight(const PointLight &light, const vec3 &direction, float cutOff);
+
+    static void clear();
+
+    // Bins and uploads the lights for the camera, call before FrameUniforms::update
+    static void update(Camera &camera);
+
+    // Results of the last update
+    inline static unsigned int visible = 0;    // Lights touching at least one cluster
+    inline static unsigned int references = 0; // Light indices over all clusters
+    inline static unsigned int dropped = 0;    // Light indices past the texture buffer size limit
+
+private:
+    // Layout of one light in the light buffer, five RGBA32F texels
+    struct GpuLight {
+        vec4 position;  // xyz, range
+        vec4 ambient;   // rgb, spot cut off, below -1 for point lights
+        vec4 diffuse;   // rgb, constant attenuation
+        vec4 specular;  // rgb, linear attenuation
+        vec4 direction; // xyz, quadratic attenuation
+    };
+
+    // Inclusive cluster range of a visible light
+    struct Bounds {
+        int minX, maxX;
+        int minY, maxY;
+        int minZ, maxZ;
+    };
+
+    // Scratch for one slice's job
+    struct SliceBins {
+        std::vector<uint32_t> candidates; // Visible lights crossing the slice
+        std::vector<uint64_t> columns;    // Per tile column, a bit per candidate
+        std::vector<uint64_t> rows;       // Per tile row, a bit per candidate
+        std::vector<uint32_t> counts;     // Per cluster in the slice
+        std::vector<uint16_t> indices;    // Cluster by cluster
+    };
+
+    static GpuLight makeLight(const PointLight &light);
+
+    static float attenuationRange(const PointLight &light);
+
+    // Same mapping as shaders/include/lights.glsl
+    static int tile(float ndc, int tiles);
+
+    static int slice(float depth);
+
+    static void binSlice(int z);
+
+    static void upload(unsigned int buffer, const void *data, size_t bytes);
+
+    inline static std::vector<GpuLight> lights; // World space
+    inline static std::vector<GpuLight> viewLights;
+    inline static std::vector<Bounds> bounds;
+    inline static std::vector<SliceBins> bins;
+    inline static std::vector<uint32_t> table; // Offset and count per cluster
+    inline static std::vector<uint16_t> indices;
+    inline static size_t maxIndices = 65536; // GL_MAX_TEXTURE_BUFFER_SIZE, 65536 is the GL 3.3 minimum
+
+    inline static float sliceScale;
+    inline static float sliceBias;
+    inline static unsigned int buffers[3];
+    inline static unsigned int textures[3];
+};
+
+}
+
+#endif // GL_LIGHT_CLUSTERS_H
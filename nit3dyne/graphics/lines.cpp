@@ -7,18 +7,26 @@ Lines::Lines(std::vector<Line> &lines) {
 }
 
 Lines::~Lines() {
-    glDeleteVertexArrays(1, &this->VAO);
+    GLState::deleteVertexArrays(1, &this->VAO);
 }
 
 void Lines::bind(std::vector<Line> &lines) {
     this->count = lines.size() * 2;
 
+    if (!lines.empty()) {
+        this->boundsMin = this->boundsMax = lines.front().vertexStart;
+        for (const Line &line : lines) {
+            this->boundsMin = glm::min(this->boundsMin, glm::min(line.vertexStart, line.vertexEnd));
+            this->boundsMax = glm::max(this->boundsMax, glm::max(line.vertexStart, line.vertexEnd));
+        }
+    }
+
     glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
+    GLState::bindVertexArray(this->VAO);
 
     unsigned int VBO;
     glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
 
     glBufferData(
             GL_ARRAY_BUFFER,
@@ -45,23 +53,26 @@ void Lines::bind(std::vector<Line> &lines) {
             (void *) offsetof(Line, colorStart)
     );
 
-    glBindVertexArray(0);
-    glDeleteBuffers(1, &VBO);
+    GLState::bindVertexArray(0);
+    GLState::deleteBuffers(1, &VBO);
 }
 
 void Lines::draw(Shader &shader, const mat4 &perspective, const mat4 &view) {
+    vec3 center = (this->boundsMin + this->boundsMax) * .5f;
+    float radius = glm::length(this->boundsMax - center);
+    if (!Frustum(perspective * view).containsBounds(this->boundsMin, this->boundsMax, center, radius, this->modelMat))
+        return;
+
     shader.use();
     mat4 mvp = perspective * view * this->modelMat;
     shader.setUniform("mvp", mvp);
 
-    glBindVertexArray(this->VAO);
+    GLState::bindVertexArray(this->VAO);
     glDrawArrays(
             GL_LINES,
             0,
             this->count
     );
-
-    glBindVertexArray(0);
 }
 
 }
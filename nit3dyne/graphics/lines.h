@@ -2,7 +2,9 @@
 #define GL_LINES_H
 
 #include "nit3dyne/core/math.h"
+#include "nit3dyne/camera/frustum.h"
 #include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/gl_state.h"
 
 namespace n3d {
 
@@ -29,6 +31,8 @@ private:
     unsigned int count;
 
     mat4 modelMat = mat4(1.f);
+    vec3 boundsMin = vec3(0.f);
+    vec3 boundsMax = vec3(0.f);
 };
 
 }
@@ -1,137 +1,177 @@
 #include "mesh.h"
 
+#include <algorithm>
+
 namespace n3d {
 
 std::string ext = ".glb";
+std::string bakedExt = ".n3m";
 std::string path = "res/mesh/";
 
-Mesh::Mesh(const std::string &resourceName, MeshType meshType) :
+Mesh::Mesh(MeshType meshType, Source &source) :
         meshType(meshType) {
+    if (source.baked) {
+        const unsigned char *data = source.baked->data();
+        const auto &header = *(const MeshHeader *) data;
+        this->bindMeshData(
+                header,
+                (const DrawPacket *) (data + header.packetOffset),
+                data + header.vertexOffset,
+                data + header.indexOffset
+        );
+    } else if (source.valid) {
+        const MeshData &meshData = source.data;
+        this->bindMeshData(
+                meshData.header, meshData.packets.data(), meshData.vertices.data(), meshData.indices.data()
+        );
+    }
+}
+
+Mesh::~Mesh() {
+    GeometryPool::free(this->geometry);
+}
+
+void Mesh::draw(Shader &shader, int lod) {
+    if (!this->geometry.valid()) return;
+    GeometryPool::bind(this->geometry);
+
+    lod = std::max(0, std::min(lod, this->lodCount - 1));
+    size_t first = (size_t) lod * this->packetCount;
+
+    if (this->multiDraw) {
+        glMultiDrawElementsBaseVertex(
+                this->packets.front().mode,
+                this->multiCounts.data() + first,
+                GL_UNSIGNED_INT,
+                this->multiOffsets.data() + first,
+                this->packetCount,
+                this->multiBaseVertices.data() + first
+        );
+        return;
+    }
+
+    for (size_t i = first; i < first + this->packetCount; ++i) {
+        const DrawPacket &packet = this->packets[i];
+        glDrawElementsBaseVertex(
+                packet.mode,
+                packet.count,
+                packet.indexType,
+                (char *) nullptr + packet.offset,
+                packet.baseVertex
+        );
+    }
+}
+
+void Mesh::drawInstanced(unsigned int vao, int instanceCount, int lod) {
+    if (!this->geometry.valid() || instanceCount <= 0) return;
+    GLState::bindVertexArray(vao);
+
+    lod = std::max(0, std::min(lod, this->lodCount - 1));
+    size_t first = (size_t) lod * this->packetCount;
+
+    for (size_t i = first; i < first + this->packetCount; ++i) {
+        const DrawPacket &packet = this->packets[i];
+        glDrawElementsInstancedBaseVertex(
+                packet.mode,
+                packet.count,
+                packet.indexType,
+                (char *) nullptr + packet.offset,
+                instanceCount,
+                packet.baseVertex
+        );
+    }
+}
+
+bool Mesh::bake(const std::string &resourceName, MeshType meshType) {
+    tinygltf::Model gltf;
+    if (!loadGltf(resourceName, gltf)) return false;
+
+    MeshData data;
+    if (!importMesh(gltf, meshType, data)) return false;
+
+    return writeMeshData(path + resourceName + bakedExt, data);
+}
+
+bool Mesh::loadGltf(const std::string &resourceName, tinygltf::Model &gltf) {
     tinygltf::TinyGLTF loader;
     std::string err, warn;
 
-    bool res = loader.LoadBinaryFromFile(&this->gltf, &err, &warn, path + resourceName + ext);
+    bool res = loader.LoadBinaryFromFile(&gltf, &err, &warn, path + resourceName + ext);
     if (!warn.empty())
         std::cout << "Mesh warning: " << warn << std::endl;
     if (!err.empty())
         std::cout << "Mesh error: " << err << std::endl;
     if (!res)
         std::cout << "Failed to load mesh: " << resourceName << std::endl;
-}
-
-Mesh::~Mesh() {
-    glDeleteVertexArrays(1, &this->VAO);
-}
-
-void Mesh::draw(Shader &shader) {
-    glBindVertexArray(this->VAO);
-
-    tinygltf::Mesh mesh = this->gltf.meshes.front();
-    tinygltf::Primitive primitive = mesh.primitives.front();
-    tinygltf::Accessor indexAccessor = this->gltf.accessors[primitive.indices];
 
-    glDrawElements(
-            primitive.mode,
-            indexAccessor.count,
-            indexAccessor.componentType,
-            (char *) nullptr + (indexAccessor.byteOffset)
-    );
-    glBindVertexArray(0);
+    return res;
 }
 
-void Mesh::bindMesh(tinygltf::Mesh &mesh, std::map<int, unsigned int> &VBOs) {
-    const tinygltf::Buffer &buffer = this->gltf.buffers.front();
-    const tinygltf::Primitive primitive = mesh.primitives.front();
+std::unique_ptr<Mesh::Source> Mesh::decode(const std::string &resourceName, MeshType meshType, bool keepGltf) {
+    auto source = std::make_unique<Source>();
 
-    for (size_t i = 0; i < this->gltf.bufferViews.size(); ++i) {
-        const tinygltf::BufferView &bufferView = this->gltf.bufferViews[i];
-        if (bufferView.target == 0) continue;
-
-        unsigned int VBO;
-        glGenBuffers(1, &VBO);
-        VBOs[i] = VBO;
-        glBindBuffer(bufferView.target, VBO);
+    auto mapping = std::make_unique<MappedFile>(path + resourceName + bakedExt);
+    if (mapping->data() != nullptr) {
+        if (validateMeshHeader(mapping->data(), mapping->size(), meshType))
+            source->baked = std::move(mapping);
+        else
+            std::cout << "Mesh error: invalid baked mesh, falling back to glTF: " << resourceName << std::endl;
+    }
 
-        glBufferData(
-            bufferView.target,
-            bufferView.byteLength,
-            &buffer.data.at(0) + bufferView.byteOffset,
-            GL_STATIC_DRAW
-        );
+    if (source->baked && !keepGltf) {
+        source->valid = true;
+        return source;
     }
 
-    for (auto &attrib : primitive.attributes) {
-        tinygltf::Accessor accessor = this->gltf.accessors[attrib.second];
+    if (!loadGltf(resourceName, source->gltf))
+        return source;
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBOs[accessor.bufferView]);
+    if (source->baked)
+        source->valid = true;
+    else
+        source->valid = importMesh(source->gltf, meshType, source->data);
 
-        int size = accessor.type;
-        int byteStride = accessor.ByteStride(
-                this->gltf.bufferViews[accessor.bufferView]
-        );
+    if (!keepGltf)
+        source->gltf = tinygltf::Model();
 
-        int vaa = this->getVaa(attrib.first);
-        if (vaa == -1) continue;
+    return source;
+}
 
-        glEnableVertexAttribArray(vaa);
-        if (this->vaaIsInt(attrib.first))
-            glVertexAttribIPointer(
-                vaa, size,
-                accessor.componentType,
-                byteStride, (char *) NULL + (accessor.byteOffset)
-            );
-        else
-            glVertexAttribPointer(
-                vaa, size,
-                accessor.componentType,
-                accessor.normalized ? GL_TRUE : GL_FALSE,
-                byteStride,
-                (char *) NULL + (accessor.byteOffset)
-            );
+void Mesh::bindMeshData(const MeshHeader &header, const DrawPacket *packets, const void *vertices, const void *indices) {
+    this->geometry = GeometryPool::allocate(vertexLayout(this->meshType), header.vertexCount, header.indexCount);
+    GeometryPool::upload(this->geometry, vertices, indices);
+
+    this->boundsMin = header.boundsMin;
+    this->boundsMax = header.boundsMax;
+    this->sphereCenter = header.sphereCenter;
+    this->sphereRadius = header.sphereRadius;
+    this->lodCount = header.lodCount;
+    this->packetCount = header.packetCount;
+    std::copy(header.lodError, header.lodError + MESH_MAX_LODS, this->lodError);
+
+    if (buildOccluders && this->meshType != MeshType::ANIMATED) {
+        this->occluder = std::make_shared<OccluderMesh>();
+        buildOccluder(header, packets, (const unsigned char *) vertices, (const uint32_t *) indices,
+                      OcclusionBuffer::occluderError, *this->occluder);
     }
-}
 
-int Mesh::getVaa(const std::string &attrib) {
-    int vaa = -1;
-
-    switch (this->meshType) {
-        case COLORED:
-            if (attrib.compare("POSITION") == 0)
-                vaa = 0;
-            if (attrib.compare("NORMAL") == 0)
-                vaa = 1;
-            if (attrib.compare("COLOR_0") == 0)
-                vaa = 2;
-            break;
-        case ANIMATED:
-            if (attrib.compare("POSITION") == 0)
-                vaa = 0;
-            if (attrib.compare("NORMAL") == 0)
-                vaa = 1;
-            if (attrib.compare("TEXCOORD_0") == 0)
-                vaa = 2;
-            if (attrib.compare("JOINTS_0") == 0)
-                vaa = 3;
-            if (attrib.compare("WEIGHTS_0") == 0)
-                vaa = 4;
-            break;
-        case STATIC:
-            if (attrib.compare("POSITION") == 0)
-                vaa = 0;
-            if (attrib.compare("NORMAL") == 0)
-                vaa = 1;
-            if (attrib.compare("TEXCOORD_0") == 0)
-                vaa = 2;
-            break;
+    // Rebase packets onto the range in the shared buffers
+    this->packets.assign(packets, packets + (size_t) header.lodCount * header.packetCount);
+    for (DrawPacket &packet : this->packets) {
+        packet.offset += this->geometry.firstIndex * sizeof(uint32_t);
+        packet.baseVertex += this->geometry.baseVertex;
     }
 
-    return vaa;
-}
+    this->multiDraw = std::all_of(this->packets.begin(), this->packets.end(), [this](const DrawPacket &packet) {
+        return packet.mode == this->packets.front().mode && packet.indexType == GL_UNSIGNED_INT;
+    });
+    if (!this->multiDraw) return;
 
-bool Mesh::vaaIsInt(const std::string &attrib) {
-    if (attrib.compare("JOINTS_0") == 0)
-        return true;
-    return false;
+    for (const DrawPacket &packet : this->packets) {
+        this->multiCounts.push_back(packet.count);
+        this->multiOffsets.push_back((char *) nullptr + packet.offset);
+        this->multiBaseVertices.push_back(packet.baseVertex);
+    }
 }
 
 }
@@ -11,35 +11,77 @@
 #include "nit3dyne/utils/gltf_utils.h"
 #include "nit3dyne/animation/skin.h"
 #include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/mesh_data.h"
+#include "nit3dyne/graphics/geometry_pool.h"
+#include "nit3dyne/graphics/occlusion_buffer.h"
+#include "nit3dyne/utils/mapped_file.h"
+#include "nit3dyne/graphics/gl_state.h"
 #include <tiny_gltf.h>
 #include <cmath>
+#include <memory>
 
 namespace n3d {
 
-enum MeshType {
-    STATIC,
-    ANIMATED,
-    COLORED
+// CPU side of a mesh load, produced by Mesh::decode on any thread
+struct MeshSource {
+    std::unique_ptr<MappedFile> baked; // Mapping of a valid .n3m, if one exists
+    MeshData data;                     // Imported glTF geometry otherwise
+    tinygltf::Model gltf;              // Loaded when geometry is not baked or the mesh needs skins/animations
+    bool valid = false;
 };
 
 class Mesh {
 public:
-    explicit Mesh(const std::string &resourceName, MeshType meshType);
+    using Source = MeshSource;
+
+    // Keep a simplified position only copy of static and colored meshes for OcclusionBuffer
+    inline static bool buildOccluders = true;
+
+    Mesh(MeshType meshType, Source &source);
     virtual ~Mesh();
 
-    virtual void draw(Shader &shader);
+    // Draws one level of the LOD chain, clamped to the levels the mesh has
+    virtual void draw(Shader &shader, int lod = 0);
+
+    // Draws instanceCount copies with a VAO that sources the mesh's block, see GeometryPool::attach
+    void drawInstanced(unsigned int vao, int instanceCount, int lod = 0);
+
+    const GeometryRange &getGeometry() const { return this->geometry; }
+
+    // Imports a glTF mesh and writes it next to the source as a baked .n3m
+    static bool bake(const std::string &resourceName, MeshType meshType);
 
     MeshType meshType;
 
+    // Bind pose bounds in mesh space
+    vec3 boundsMin = vec3(0.f);
+    vec3 boundsMax = vec3(0.f);
+    vec3 sphereCenter = vec3(0.f);
+    float sphereRadius = 0.f;
+
+    int lodCount = 0;
+    float lodError[MESH_MAX_LODS] = {}; // Geometric deviation of each level, in mesh units
+
+    std::shared_ptr<OccluderMesh> occluder; // Null for skinned meshes or with buildOccluders off
+
 protected:
-    void bindMesh(tinygltf::Mesh &mesh, std::map<int, unsigned int> &VBOs);
+    // Maps the baked file if there is one, otherwise imports the glTF. keepGltf also loads the glTF for baked meshes.
+    static std::unique_ptr<Source> decode(const std::string &resourceName, MeshType meshType, bool keepGltf);
 
-    unsigned int VAO;
-    tinygltf::Model gltf;
+    static bool loadGltf(const std::string &resourceName, tinygltf::Model &gltf);
+
+    GeometryRange geometry;
+    std::vector<DrawPacket> packets; // lodCount * packetCount, offsets and base vertices are absolute within the pool block
+    int packetCount = 0;             // Per LOD
 
 private:
-    int getVaa(const std::string &attrib);
-    bool vaaIsInt(const std::string &attrib);
+    // Packets of a single mode are issued as one glMultiDrawElementsBaseVertex per LOD
+    bool multiDraw = false;
+    std::vector<GLsizei> multiCounts;
+    std::vector<const void *> multiOffsets;
+    std::vector<GLint> multiBaseVertices;
+
+    void bindMeshData(const MeshHeader &header, const DrawPacket *packets, const void *vertices, const void *indices);
 };
 
 }
@@ -1,40 +1,45 @@
 #include "mesh_animated.h"
 
+#include <algorithm>
+
 namespace n3d {
 
-MeshAnimated::MeshAnimated(const std::string &resourceName) : Mesh(resourceName, MeshType::ANIMATED) {
-    this->bindModel();
+MeshAnimated::MeshAnimated(const std::string &resourceName) : MeshAnimated(resourceName, *decode(resourceName)) {}
+
+MeshAnimated::MeshAnimated(const std::string &resourceName, Source &source) : Mesh(MeshType::ANIMATED, source) {
+    if (!source.valid) return;
 
-    for (auto &animation : this->gltf.animations) {
-        this->animations.emplace_back(Animation(this->gltf, animation, this->skin));
+    tinygltf::Model &gltf = source.gltf;
+    this->bindModel(gltf);
+
+    for (auto &animation : gltf.animations) {
+        this->animations.emplace_back(Animation(gltf, animation, this->skin));
     }
 
     this->animator = Animator(&this->skin);
     this->animator.setAnimation(this->animations.front());
+
+    this->bindJointBounds(source);
 }
 
-void MeshAnimated::bindModel() {
-    glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
+std::unique_ptr<Mesh::Source> MeshAnimated::decode(const std::string &resourceName) {
+    // Skin and animations are not baked, the document is only kept until construction
+    return Mesh::decode(resourceName, MeshType::ANIMATED, true);
+}
 
-    std::map<int, unsigned int> VBOs;
+void MeshAnimated::bindModel(tinygltf::Model &gltf) {
     mat4 globalTransform(1.f);
 
     this->bindModelNodes(
+            gltf,
             -1,
-            this->gltf.scenes[this->gltf.defaultScene].nodes.front(),
-            VBOs, globalTransform
+            gltf.scenes[gltf.defaultScene].nodes.front(),
+            globalTransform
     );
-
-    // Cleanup
-    glBindVertexArray(0);
-    for (size_t i = 0; i < VBOs.size(); ++i) {
-        glDeleteBuffers(1, &VBOs[i]);
-    }
 }
 
-void MeshAnimated::bindModelNodes(int parentId, int nodeId, std::map<int, unsigned int> &VBOs, mat4 &globalTransform) {
-    tinygltf::Node node = this->gltf.nodes[nodeId];
+void MeshAnimated::bindModelNodes(tinygltf::Model &gltf, int parentId, int nodeId, mat4 &globalTransform) {
+    tinygltf::Node &node = gltf.nodes[nodeId];
 
     quat rotation(1.f, 0.f, 0.f, 0.f);
     if (!node.rotation.empty())
@@ -53,8 +58,7 @@ void MeshAnimated::bindModelNodes(int parentId, int nodeId, std::map<int, unsign
             scale
     );
 
-    if (node.skin >= 0) this->bindSkin(this->gltf.skins[node.skin], nodeTransform);
-    if (node.mesh >= 0) this->bindMesh(this->gltf.meshes[node.mesh], VBOs);
+    if (node.skin >= 0) this->bindSkin(gltf, gltf.skins[node.skin], nodeTransform);
 
     // Bind joints, assumes skin already found
     if (this->skin.isJoint(nodeId)) {
@@ -73,14 +77,13 @@ void MeshAnimated::bindModelNodes(int parentId, int nodeId, std::map<int, unsign
 
     // Recur down node tree
     for (int i : node.children)
-        bindModelNodes(nodeId, i, VBOs, nodeTransform);
+        bindModelNodes(gltf, nodeId, i, nodeTransform);
 }
 
-void MeshAnimated::bindSkin(tinygltf::Skin &skin, mat4 &globalTransform) {
-    tinygltf::Accessor &ibmAccessor = this->gltf.accessors[skin.inverseBindMatrices];
-    tinygltf::BufferView &ibmView = this->gltf.bufferViews[ibmAccessor.bufferView];
+void MeshAnimated::bindSkin(tinygltf::Model &gltf, tinygltf::Skin &skin, mat4 &globalTransform) {
+    tinygltf::Accessor &ibmAccessor = gltf.accessors[skin.inverseBindMatrices];
     std::vector<mat4> inverseBindMats;
-    readBuffer<mat4>(ibmAccessor, this->gltf, inverseBindMats);
+    readBuffer<mat4>(ibmAccessor, gltf, inverseBindMats);
 
     for (size_t i = 0; i < skin.joints.size(); ++i) {
         this->skin.joints.emplace_back(std::pair<int, Joint>(skin.joints[i], Joint(i, inverseBindMats[i])));
@@ -89,17 +92,84 @@ void MeshAnimated::bindSkin(tinygltf::Skin &skin, mat4 &globalTransform) {
     this->skin.globalTransform = globalTransform;
 }
 
-void MeshAnimated::draw(Shader &shader) {
+void MeshAnimated::draw(Shader &shader, int lod) {
+    std::vector<mat4> jointMatrices;
+    this->pose(jointMatrices);
+    this->drawPose(shader, jointMatrices.data(), jointMatrices.size(), lod);
+}
+
+void MeshAnimated::pose(std::vector<mat4> &jointMatrices) {
     this->animator.update();
 
-    std::vector<mat4> jointMatrices;
+    jointMatrices.clear();
     for (auto &pJoint : this->skin.joints) {
         jointMatrices.push_back(pJoint.second.getJointMatrix(this->skin.globalTransform));
     }
 
-    shader.setUniform("jointTransforms", jointMatrices);
+    // Cull tests before the next draw see the pose drawn here
+    this->updateBounds(jointMatrices);
+}
+
+void MeshAnimated::drawPose(Shader &shader, const mat4 *jointMatrices, size_t count, int lod) {
+    // Always the whole block, a bound range smaller than the block is undefined
+    auto palette = FrameUniforms::stream->allocate<mat4>(MAX_JOINTS);
+    if (palette) {
+        count = std::min(count, (size_t) MAX_JOINTS);
+        std::copy(jointMatrices, jointMatrices + count, palette.begin());
+        std::fill(palette.begin() + count, palette.end(), mat4(1.f));
+        FrameUniforms::stream->commit();
+
+        GLState::bindBufferRange(GL_UNIFORM_BUFFER, BINDING_JOINTS, FrameUniforms::stream->getHandle(),
+                                 palette.offset, palette.bytes());
+    }
+
+    Mesh::draw(shader, lod);
+}
+
+void MeshAnimated::bindJointBounds(const Source &source) {
+    const MeshHeader *header = &source.data.header;
+    const unsigned char *vertices = source.data.vertices.data();
+    if (source.baked) {
+        header = (const MeshHeader *) source.baked->data();
+        vertices = source.baked->data() + header->vertexOffset;
+    }
+
+    this->jointBindPositions.resize(this->skin.joints.size());
+    this->jointRadii.assign(this->skin.joints.size(), -1.f);
+    for (size_t i = 0; i < this->skin.joints.size(); ++i)
+        this->jointBindPositions[i] = vec3(inverse(this->skin.joints[i].second.inverseBindTransform)[3]);
+
+    for (size_t v = 0; v < header->vertexCount; ++v) {
+        const auto &vertex = *(const VertexAnimated *) (vertices + v * sizeof(VertexAnimated));
+        for (int k = 0; k < 4; ++k) {
+            uint16_t joint = vertex.joints[k];
+            if (vertex.weights[k] <= 0.f || joint >= this->jointRadii.size()) continue;
+
+            float distance = glm::length(vertex.position - this->jointBindPositions[joint]);
+            this->jointRadii[joint] = std::max(this->jointRadii[joint], distance);
+        }
+    }
+
+    this->updateBounds(std::vector<mat4>(this->skin.joints.size(), mat4(1.f)));
+}
+
+void MeshAnimated::updateBounds(const std::vector<mat4> &jointMatrices) {
+    bool empty = true;
+
+    // Skinned vertices blend rigid transforms of their joints, so each stays within its joints' spheres
+    for (size_t i = 0; i < jointMatrices.size() && i < this->jointRadii.size(); ++i) {
+        if (this->jointRadii[i] < 0.f) continue;
+
+        vec3 position = vec3(jointMatrices[i] * vec4(this->jointBindPositions[i], 1.f));
+        vec3 radius(this->jointRadii[i]);
+        this->boundsMin = empty ? position - radius : glm::min(this->boundsMin, position - radius);
+        this->boundsMax = empty ? position + radius : glm::max(this->boundsMax, position + radius);
+        empty = false;
+    }
+    if (empty) return;
 
-    Mesh::draw(shader);
+    this->sphereCenter = (this->boundsMin + this->boundsMax) * .5f;
+    this->sphereRadius = glm::length(this->boundsMax - this->sphereCenter);
 }
 
 }
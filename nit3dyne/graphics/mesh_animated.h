@@ -3,6 +3,7 @@
 
 #include "nit3dyne/graphics/mesh.h"
 #include "nit3dyne/animation/animator.h"
+#include "nit3dyne/graphics/frame_uniforms.h"
 #include <iostream>
 
 namespace n3d {
@@ -11,18 +12,39 @@ class MeshAnimated : public Mesh {
 public:
     explicit MeshAnimated(const std::string &resourceName);
 
+    MeshAnimated(const std::string &resourceName, Source &source);
+
     ~MeshAnimated() override = default;
 
-    void draw(Shader &shader) override;
+    void draw(Shader &shader, int lod = 0) override;
+
+    // Advances the animation and writes the joint palette, no GL so it can run on a worker
+    void pose(std::vector<mat4> &jointMatrices);
+
+    // Draws with a palette from pose, GL thread
+    void drawPose(Shader &shader, const mat4 *jointMatrices, size_t count, int lod = 0);
 
     void changeAnim();
 
+    const Skin &getSkin() const { return this->skin; }
+
+    static std::unique_ptr<Source> decode(const std::string &resourceName);
+
 private:
-    void bindModel();
+    void bindModel(tinygltf::Model &gltf);
+
+    void bindModelNodes(tinygltf::Model &gltf, int parentId, int nodeId, mat4 &globalTransform);
+
+    void bindSkin(tinygltf::Model &gltf, tinygltf::Skin &skin, mat4 &globalTransform);
+
+    // Distance from each joint to the furthest vertex it influences, in the bind pose
+    void bindJointBounds(const Source &source);
 
-    void bindModelNodes(int parentId, int nodeId, std::map<int, unsigned int> &VBOs, mat4 &globalTransform);
+    // Bounds are the joints in the current pose, each grown by its radius
+    void updateBounds(const std::vector<mat4> &jointMatrices);
 
-    void bindSkin(tinygltf::Skin &skin, mat4 &globalTransform);
+    std::vector<vec3> jointBindPositions;
+    std::vector<float> jointRadii; // Negative for joints without vertices
 
     Skin skin;
     std::vector<Animation> animations;
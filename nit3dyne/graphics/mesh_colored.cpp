@@ -4,38 +4,12 @@
 namespace n3d{
 
 
-MeshColored::MeshColored(const std::string &resourceName) : Mesh(resourceName, MeshType::COLORED) {
-    this->bindModel();
-}
-
-void MeshColored::bindModel() {
-    glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
-
-    std::map<int, unsigned int> VBOs;
-    mat4 globalTransform(1.f);
-
-    this->bindModelNodes(
-            -1,
-            this->gltf.scenes[this->gltf.defaultScene].nodes.front(),
-            VBOs, globalTransform
-    );
-
-    // Cleanup
-    glBindVertexArray(0);
-    for (size_t i = 0; i < VBOs.size(); ++i) {
-        glDeleteBuffers(1, &VBOs[i]);
-    }
-}
-
-void MeshColored::bindModelNodes(int parentId, int nodeId, std::map<int, unsigned int> &VBOs, mat4 &globalTransform) {
-    tinygltf::Node node = this->gltf.nodes[nodeId];
+MeshColored::MeshColored(const std::string &resourceName) : MeshColored(resourceName, *decode(resourceName)) {}
 
-    if (node.mesh >= 0)
-        this->bindMesh(this->gltf.meshes[node.mesh], VBOs);
+MeshColored::MeshColored(const std::string &resourceName, Source &source) : Mesh(MeshType::COLORED, source) {}
 
-    for (int i : node.children)
-        bindModelNodes(nodeId, i, VBOs, globalTransform);
+std::unique_ptr<Mesh::Source> MeshColored::decode(const std::string &resourceName) {
+    return Mesh::decode(resourceName, MeshType::COLORED, false);
 }
 
 }
@@ -11,11 +11,10 @@ namespace n3d {
 class MeshColored : public Mesh {
 public:
     explicit MeshColored(const std::string &resourceName);
+    MeshColored(const std::string &resourceName, Source &source);
     ~MeshColored() override = default;
 
-private:
-    void bindModel();
-    void bindModelNodes(int parentId, int nodeId, std::map<int, unsigned int> &VBOs, mat4 &globalTransform);
+    static std::unique_ptr<Source> decode(const std::string &resourceName);
 };
 
 
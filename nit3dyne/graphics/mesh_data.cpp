@@ -0,0 +1,298 @@
+#include "mesh_data.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <glad/glad.h>
+
+#include "nit3dyne/graphics/mesh_optimize.h"
+#include "nit3dyne/graphics/mesh_simplify.h"
+#include "nit3dyne/utils/gltf_utils.h"
+
+namespace n3d {
+
+unsigned int vertexStride(MeshType meshType) {
+    switch (meshType) {
+        case COLORED:
+            return sizeof(VertexColored);
+        case ANIMATED:
+            return sizeof(VertexAnimated);
+        case STATIC:
+        default:
+            return sizeof(VertexStatic);
+    }
+}
+
+static void readAttribute(const tinygltf::Model &gltf,
+                          const tinygltf::Primitive &primitive,
+                          const std::string &attrib,
+                          std::vector<float> &data,
+                          int &components) {
+    auto found = primitive.attributes.find(attrib);
+    components = 0;
+    if (found != primitive.attributes.end())
+        components = readAccessor(gltf, found->second, data);
+}
+
+// Copies up to n components of element i, missing components stay zero
+static void copyElement(float *dst, int n, const std::vector<float> &src, int components, size_t i) {
+    for (int c = 0; c < n && c < components; ++c)
+        dst[c] = src[i * components + c];
+}
+
+// Appends one primitive's vertices and indices to out, returns false if it cannot be drawn
+static bool importPrimitive(const tinygltf::Model &gltf,
+                            const tinygltf::Primitive &primitive,
+                            MeshType meshType,
+                            const mat4 &transform,
+                            MeshData &out) {
+    auto position = primitive.attributes.find("POSITION");
+    if (position == primitive.attributes.end()) {
+        std::cout << "Mesh warning: skipping primitive without positions" << std::endl;
+        return false;
+    }
+    size_t vertexCount = gltf.accessors[position->second].count;
+
+    std::vector<float> positions, normals, uvs, colors, weights;
+    std::vector<uint32_t> joints;
+    int nPosition, nNormal, nUv = 0, nColor = 0, nWeight = 0, nJoint = 0;
+
+    readAttribute(gltf, primitive, "POSITION", positions, nPosition);
+    readAttribute(gltf, primitive, "NORMAL", normals, nNormal);
+    if (meshType == COLORED) {
+        readAttribute(gltf, primitive, "COLOR_0", colors, nColor);
+    } else {
+        readAttribute(gltf, primitive, "TEXCOORD_0", uvs, nUv);
+    }
+    if (meshType == ANIMATED) {
+        readAttribute(gltf, primitive, "WEIGHTS_0", weights, nWeight);
+        auto found = primitive.attributes.find("JOINTS_0");
+        if (found != primitive.attributes.end())
+            nJoint = readAccessor(gltf, found->second, joints);
+    }
+
+    if (transform != mat4(1.f)) {
+        mat3 normalMat = inverse(transpose(mat3(transform)));
+        for (size_t i = 0; nPosition >= 3 && i < vertexCount; ++i) {
+            vec3 p = vec3(transform * vec4(make_vec3(&positions[i * nPosition]), 1.f));
+            std::copy_n(&p.x, 3, &positions[i * nPosition]);
+        }
+        for (size_t i = 0; nNormal >= 3 && i < vertexCount; ++i) {
+            vec3 n = normalize(normalMat * make_vec3(&normals[i * nNormal]));
+            std::copy_n(&n.x, 3, &normals[i * nNormal]);
+        }
+    }
+
+    DrawPacket packet{};
+    packet.mode = primitive.mode < 0 ? TINYGLTF_MODE_TRIANGLES : primitive.mode;
+    packet.indexType = GL_UNSIGNED_INT;
+    packet.offset = out.indices.size() * sizeof(uint32_t);
+    packet.baseVertex = out.vertices.size() / vertexStride(meshType);
+    packet.vertexCount = vertexCount;
+    packet.material = primitive.material;
+
+    // Non-indexed primitives get a trivial index list so every packet draws the same way
+    if (primitive.indices >= 0) {
+        readAccessor(gltf, primitive.indices, out.indices);
+    } else {
+        for (size_t i = 0; i < vertexCount; ++i)
+            out.indices.push_back(i);
+    }
+    packet.count = out.indices.size() - packet.offset / sizeof(uint32_t);
+
+    unsigned int stride = vertexStride(meshType);
+    size_t first = out.vertices.size();
+    out.vertices.resize(first + vertexCount * stride, 0);
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        unsigned char *dst = out.vertices.data() + first + i * stride;
+
+        switch (meshType) {
+            case STATIC: {
+                auto *v = (VertexStatic *) dst;
+                copyElement(&v->position.x, 3, positions, nPosition, i);
+                copyElement(&v->normal.x, 3, normals, nNormal, i);
+                copyElement(&v->uv.x, 2, uvs, nUv, i);
+                break;
+            }
+            case COLORED: {
+                auto *v = (VertexColored *) dst;
+                copyElement(&v->position.x, 3, positions, nPosition, i);
+                copyElement(&v->normal.x, 3, normals, nNormal, i);
+                copyElement(&v->color.x, 3, colors, nColor, i);
+                break;
+            }
+            case ANIMATED: {
+                auto *v = (VertexAnimated *) dst;
+                copyElement(&v->position.x, 3, positions, nPosition, i);
+                copyElement(&v->normal.x, 3, normals, nNormal, i);
+                copyElement(&v->uv.x, 2, uvs, nUv, i);
+                copyElement(&v->weights.x, 4, weights, nWeight, i);
+                for (int c = 0; c < 4 && c < nJoint; ++c)
+                    v->joints[c] = (uint16_t) joints[i * nJoint + c];
+                break;
+            }
+        }
+    }
+
+    out.packets.push_back(packet);
+    return true;
+}
+
+// Node matrix, or translation * rotation * scale
+static mat4 nodeTransform(const tinygltf::Node &node) {
+    if (node.matrix.size() == 16) {
+        mat4 out;
+        for (int i = 0; i < 16; ++i)
+            out[i / 4][i % 4] = (float) node.matrix[i];
+        return out;
+    }
+
+    mat4 out(1.f);
+    if (!node.translation.empty())
+        out = translate(out, vec3(node.translation[0], node.translation[1], node.translation[2]));
+    if (!node.rotation.empty())
+        out *= toMat4(quat((float) node.rotation[3], (float) node.rotation[0], (float) node.rotation[1],
+                           (float) node.rotation[2]));
+    if (!node.scale.empty())
+        out = scale(out, vec3(node.scale[0], node.scale[1], node.scale[2]));
+    return out;
+}
+
+static void importNode(const tinygltf::Model &gltf, int nodeId, const mat4 &parent, MeshType meshType,
+                       MeshData &out) {
+    const tinygltf::Node &node = gltf.nodes[nodeId];
+    mat4 world = parent * nodeTransform(node);
+
+    // Joints place skinned vertices, the node transform does not apply to them
+    if (node.mesh >= 0) {
+        mat4 transform = node.skin >= 0 ? mat4(1.f) : world;
+        for (auto &primitive : gltf.meshes[node.mesh].primitives)
+            importPrimitive(gltf, primitive, meshType, transform, out);
+    }
+
+    for (int child : node.children)
+        importNode(gltf, child, world, meshType, out);
+}
+
+// Axis aligned box and a sphere around the box center, every layout starts with its position
+static void computeBounds(MeshHeader &header, const std::vector<unsigned char> &vertices) {
+    header.boundsMin = vec3(0.f);
+    header.boundsMax = vec3(0.f);
+    header.sphereCenter = vec3(0.f);
+    header.sphereRadius = 0.f;
+    if (header.vertexCount == 0) return;
+
+    header.boundsMin = vec3(std::numeric_limits<float>::max());
+    header.boundsMax = vec3(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i < header.vertexCount; ++i) {
+        const auto &position = *(const vec3 *) (vertices.data() + i * header.vertexStride);
+        header.boundsMin = glm::min(header.boundsMin, position);
+        header.boundsMax = glm::max(header.boundsMax, position);
+    }
+
+    header.sphereCenter = (header.boundsMin + header.boundsMax) * .5f;
+    for (size_t i = 0; i < header.vertexCount; ++i) {
+        const auto &position = *(const vec3 *) (vertices.data() + i * header.vertexStride);
+        header.sphereRadius = std::max(header.sphereRadius, glm::length(position - header.sphereCenter));
+    }
+}
+
+bool importMesh(const tinygltf::Model &gltf, MeshType meshType, MeshData &out) {
+    out.packets.clear();
+    out.vertices.clear();
+    out.indices.clear();
+
+    if (!gltf.scenes.empty()) {
+        int scene = gltf.defaultScene >= 0 ? gltf.defaultScene : 0;
+        for (int node : gltf.scenes[scene].nodes)
+            importNode(gltf, node, mat4(1.f), meshType, out);
+    } else {
+        for (auto &mesh : gltf.meshes) {
+            for (auto &primitive : mesh.primitives)
+                importPrimitive(gltf, primitive, meshType, mat4(1.f), out);
+        }
+    }
+
+    if (out.packets.empty()) {
+        std::cout << "Mesh error: no drawable primitives" << std::endl;
+        return false;
+    }
+
+    unsigned int stride = vertexStride(meshType);
+
+    MeshHeader &header = out.header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MESH_MAGIC, sizeof(header.magic));
+    header.version = MESH_VERSION;
+    header.meshType = meshType;
+    header.vertexStride = stride;
+    header.vertexCount = out.vertices.size() / stride;
+    header.packetCount = out.packets.size();
+    header.lodCount = 1;
+    computeBounds(header, out.vertices);
+
+    // glTF order is as authored, tune it for the post-transform cache before upload or baking
+    optimizeMesh(out);
+    generateLods(out);
+
+    // LODs append packets and indices, lay out the blobs last
+    header.indexCount = out.indices.size();
+    header.packetOffset = sizeof(MeshHeader);
+    header.vertexOffset = header.packetOffset + out.packets.size() * sizeof(DrawPacket);
+    header.indexOffset = header.vertexOffset + out.vertices.size();
+
+    return true;
+}
+
+bool writeMeshData(const std::string &fileName, const MeshData &data) {
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Failed to write mesh: " << fileName << std::endl;
+        return false;
+    }
+
+    // Blobs are written in the order the header offsets describe
+    file.write((const char *) &data.header, sizeof(MeshHeader));
+    file.write((const char *) data.packets.data(), data.packets.size() * sizeof(DrawPacket));
+    file.write((const char *) data.vertices.data(), data.vertices.size());
+    file.write((const char *) data.indices.data(), data.indices.size() * sizeof(uint32_t));
+
+    return (bool) file;
+}
+
+bool validateMeshHeader(const unsigned char *data, size_t size, MeshType meshType) {
+    if (data == nullptr || size < sizeof(MeshHeader)) return false;
+
+    const auto *header = (const MeshHeader *) data;
+    if (std::memcmp(header->magic, MESH_MAGIC, sizeof(header->magic)) != 0) return false;
+    if (header->version != MESH_VERSION) return false;
+    if (header->meshType != (uint32_t) meshType) return false;
+    if (header->vertexStride != vertexStride(meshType)) return false;
+    if (header->lodCount == 0 || header->lodCount > MESH_MAX_LODS) return false;
+
+    uint64_t packetEnd = header->packetOffset
+                         + (uint64_t) header->lodCount * header->packetCount * sizeof(DrawPacket);
+    uint64_t vertexEnd = header->vertexOffset + (uint64_t) header->vertexCount * header->vertexStride;
+    uint64_t indexEnd = header->indexOffset + (uint64_t) header->indexCount * sizeof(uint32_t);
+    if (packetEnd > size || vertexEnd > size || indexEnd > size
+        || header->packetOffset % alignof(DrawPacket) != 0
+        || header->indexOffset % sizeof(uint32_t) != 0)
+        return false;
+
+    // Packet ranges feed CPU reads (occluders) as well as GL, keep them inside the blobs
+    const auto *packets = (const DrawPacket *) (data + header->packetOffset);
+    for (uint32_t i = 0; i < header->lodCount * header->packetCount; ++i) {
+        const DrawPacket &packet = packets[i];
+        if (packet.indexType != GL_UNSIGNED_INT || packet.offset % sizeof(uint32_t) != 0) return false;
+        if (packet.offset / sizeof(uint32_t) + (uint64_t) packet.count > header->indexCount) return false;
+        if (packet.baseVertex < 0 || (uint64_t) packet.baseVertex + packet.vertexCount > header->vertexCount)
+            return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,103 @@
+#ifndef GL_MESH_DATA_H
+#define GL_MESH_DATA_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nit3dyne/core/math.h"
+#include <tiny_gltf.h>
+
+namespace n3d {
+
+enum MeshType {
+    STATIC,
+    ANIMATED,
+    COLORED
+};
+
+// Interleaved vertex layouts, one per mesh type
+struct VertexStatic {
+    vec3 position;
+    vec3 normal;
+    vec2 uv;
+};
+
+struct VertexColored {
+    vec3 position;
+    vec3 normal;
+    vec3 color;
+};
+
+struct VertexAnimated {
+    vec3 position;
+    vec3 normal;
+    vec2 uv;
+    uint16_t joints[4];
+    vec4 weights;
+};
+
+unsigned int vertexStride(MeshType meshType);
+
+// One glTF primitive, resolved at load so drawing needs no lookups
+struct DrawPacket {
+    uint32_t mode;        // GL primitive mode
+    uint32_t count;       // Index count
+    uint32_t indexType;   // GL index type
+    uint32_t offset;      // Byte offset into the index buffer
+    int32_t baseVertex;
+    uint32_t vertexCount;
+    int32_t material;     // glTF material slot, -1 if unassigned
+    uint32_t reserved;
+};
+
+/*
+ * Baked mesh file (.n3m), little endian:
+ *   MeshHeader
+ *   packet table, lodCount * packetCount * DrawPacket, LOD 0 first
+ *   vertex blob, vertexCount * vertexStride bytes, interleaved
+ *   index blob, indexCount * uint32
+ * Offsets are from the start of the file so the blobs can be handed to GL straight from a mapping.
+ */
+const char MESH_MAGIC[4] = {'N', '3', 'M', '\0'};
+const uint32_t MESH_VERSION = 3;
+const uint32_t MESH_MAX_LODS = 4;
+
+struct MeshHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t meshType;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t packetCount;                // Packets per LOD
+    uint32_t lodCount;
+    uint64_t packetOffset;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    vec3 boundsMin;
+    vec3 boundsMax;
+    vec3 sphereCenter;
+    float sphereRadius;
+    float lodError[MESH_MAX_LODS];       // Largest geometric deviation of each LOD, in mesh units
+};
+
+struct MeshData {
+    MeshHeader header;
+    std::vector<DrawPacket> packets;
+    std::vector<unsigned char> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Converts the primitives of every mesh node in the default scene into the interleaved layout of meshType,
+// with node transforms baked in. Skinned nodes stay in bind space, files without nodes import every mesh as is.
+bool importMesh(const tinygltf::Model &gltf, MeshType meshType, MeshData &out);
+
+bool writeMeshData(const std::string &fileName, const MeshData &data);
+
+// Checks a mapped baked file, size is the length of the mapping
+bool validateMeshHeader(const unsigned char *data, size_t size, MeshType meshType);
+
+}
+
+#endif // GL_MESH_DATA_H
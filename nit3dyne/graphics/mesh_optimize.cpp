@@ -0,0 +1,286 @@
+#include "mesh_optimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace n3d {
+
+// Forsyth scoring parameters
+const int CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRI_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+// Every vertex layout starts with its position
+static vec3 vertexPosition(const unsigned char *vertices, size_t stride, uint32_t index) {
+    vec3 position;
+    std::memcpy(&position, vertices + index * stride, sizeof(vec3));
+    return position;
+}
+
+VertexCacheStats analyzeVertexCache(const uint32_t *indices, size_t indexCount, size_t vertexCount,
+                                    unsigned int cacheSize) {
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0) return stats;
+
+    // Timestamps emulate a FIFO without moving entries
+    std::vector<size_t> cachedAt(vertexCount, 0);
+    std::vector<bool> seen(vertexCount, false);
+    size_t timestamp = cacheSize + 1;
+    size_t misses = 0;
+    size_t unique = 0;
+
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t v = indices[i];
+        if (!seen[v]) {
+            seen[v] = true;
+            ++unique;
+        }
+
+        if (timestamp - cachedAt[v] > cacheSize) {
+            cachedAt[v] = timestamp++;
+            ++misses;
+        }
+    }
+
+    stats.acmr = (float) misses / (indexCount / 3);
+    stats.atvr = unique == 0 ? 0.f : (float) misses / unique;
+    return stats;
+}
+
+static float vertexScore(int cachePosition, int remainingTriangles) {
+    if (remainingTriangles == 0) return -1.f;
+
+    float score = 0.f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // Vertices of the last triangle get a fixed score so it is not immediately reused
+            score = LAST_TRI_SCORE;
+        } else {
+            float scaler = 1.f / (CACHE_SIZE - 3);
+            score = std::pow(1.f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Boost vertices with few triangles left so they get finished off
+    score += VALENCE_BOOST_SCALE * std::pow((float) remainingTriangles, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+void optimizeVertexCache(uint32_t *indices, size_t indexCount, size_t vertexCount) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) return;
+
+    // Vertex to triangle adjacency
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        ++adjacencyOffset[indices[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffset[v + 1] += adjacencyOffset[v];
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+            adjacency[fill[indices[t * 3 + k]]++] = t;
+
+    std::vector<int> remaining(vertexCount);
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        remaining[v] = adjacencyOffset[v + 1] - adjacencyOffset[v];
+        score[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(CACHE_SIZE + 3);
+    nextCache.reserve(CACHE_SIZE + 3);
+
+    size_t fallbackCursor = 0;
+    long best = -1;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        // Nothing adjacent to the cache, continue with the next triangle in input order
+        if (best < 0) {
+            for (; emitted[fallbackCursor]; ++fallbackCursor);
+            best = fallbackCursor;
+        }
+
+        const uint32_t *tri = indices + best * 3;
+        output.insert(output.end(), tri, tri + 3);
+        emitted[best] = true;
+
+        // Emitted triangle's vertices move to the front of the LRU cache
+        nextCache.assign(tri, tri + 3);
+        for (uint32_t v : cache)
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                nextCache.push_back(v);
+
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            --remaining[v];
+
+            // Drop the triangle from the vertex's live adjacency
+            uint32_t *begin = adjacency.data() + adjacencyOffset[v];
+            uint32_t *end = begin + remaining[v] + 1;
+            std::iter_swap(std::find(begin, end, (uint32_t) best), end - 1);
+        }
+
+        for (size_t i = 0; i < nextCache.size(); ++i) {
+            uint32_t v = nextCache[i];
+            cachePosition[v] = i < (size_t) CACHE_SIZE ? (int) i : -1;
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+        if (nextCache.size() > (size_t) CACHE_SIZE)
+            nextCache.resize(CACHE_SIZE);
+        std::swap(cache, nextCache);
+
+        // Rescore triangles touching the cache and pick the next one among them
+        best = -1;
+        float bestScore = -1.f;
+        for (uint32_t v : cache) {
+            const uint32_t *adjacent = adjacency.data() + adjacencyOffset[v];
+            for (int i = 0; i < remaining[v]; ++i) {
+                uint32_t t = adjacent[i];
+                const uint32_t *candidate = indices + t * 3;
+                triangleScore[t] = score[candidate[0]] + score[candidate[1]] + score[candidate[2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(uint32_t *indices, size_t indexCount,
+                      const unsigned char *vertices, size_t vertexCount, size_t stride) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) return;
+
+    // Cluster boundaries where the cache simulation restarts, i.e. a triangle missing on all 3 vertices
+    std::vector<size_t> clusterStart;
+    std::vector<size_t> cachedAt(vertexCount, 0);
+    size_t timestamp = CACHE_SIZE + 1;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = indices[t * 3 + k];
+            if (timestamp - cachedAt[v] > (size_t) CACHE_SIZE) {
+                cachedAt[v] = timestamp++;
+                ++misses;
+            }
+        }
+        if (t == 0 || misses == 3)
+            clusterStart.push_back(t);
+    }
+    if (clusterStart.size() < 2) return;
+    clusterStart.push_back(triangleCount);
+
+    vec3 meshCentroid(0.f);
+    for (size_t i = 0; i < indexCount; ++i)
+        meshCentroid += vertexPosition(vertices, stride, indices[i]);
+    meshCentroid /= (float) indexCount;
+
+    // Clusters facing away from the mesh center are likely to occlude the rest, draw them first
+    size_t clusterCount = clusterStart.size() - 1;
+    std::vector<float> sortKey(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        vec3 centroid(0.f);
+        vec3 normal(0.f);
+        float totalArea = 0.f;
+
+        for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; ++t) {
+            vec3 a = vertexPosition(vertices, stride, indices[t * 3]);
+            vec3 b = vertexPosition(vertices, stride, indices[t * 3 + 1]);
+            vec3 d = vertexPosition(vertices, stride, indices[t * 3 + 2]);
+
+            // Area weighted, the cross product's length is twice the triangle area
+            vec3 n = cross(b - a, d - a);
+            float area = glm::length(n);
+            centroid += (a + b + d) * (area / 3.f);
+            normal += n;
+            totalArea += area;
+        }
+
+        if (totalArea > 0.f) centroid /= totalArea;
+        float normalLength = glm::length(normal);
+        sortKey[c] = normalLength > 0.f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.f;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&sortKey](size_t l, size_t r) { return sortKey[l] > sortKey[r]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    for (size_t c : order)
+        output.insert(output.end(), indices + clusterStart[c] * 3, indices + clusterStart[c + 1] * 3);
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeVertexFetch(unsigned char *vertices, uint32_t *indices, size_t indexCount,
+                         size_t vertexCount, size_t stride) {
+    const uint32_t unassigned = ~0u;
+    std::vector<uint32_t> remap(vertexCount, unassigned);
+    uint32_t next = 0;
+
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t &target = remap[indices[i]];
+        if (target == unassigned)
+            target = next++;
+        indices[i] = target;
+    }
+
+    // Unreferenced vertices keep their relative order at the end
+    for (uint32_t &target : remap)
+        if (target == unassigned)
+            target = next++;
+
+    std::vector<unsigned char> reordered(vertexCount * stride);
+    for (size_t v = 0; v < vertexCount; ++v)
+        std::memcpy(reordered.data() + remap[v] * stride, vertices + v * stride, stride);
+
+    std::copy(reordered.begin(), reordered.end(), vertices);
+}
+
+void optimizeMesh(MeshData &data) {
+    unsigned int stride = data.header.vertexStride;
+
+    for (DrawPacket &packet : data.packets) {
+        if (packet.mode != GL_TRIANGLES || packet.count < 3) continue;
+
+        uint32_t *indices = data.indices.data() + packet.offset / sizeof(uint32_t);
+        unsigned char *vertices = data.vertices.data() + (size_t) packet.baseVertex * stride;
+
+        VertexCacheStats before = analyzeVertexCache(indices, packet.count, packet.vertexCount);
+
+        optimizeVertexCache(indices, packet.count, packet.vertexCount);
+        optimizeOverdraw(indices, packet.count, vertices, packet.vertexCount, stride);
+        optimizeVertexFetch(vertices, indices, packet.count, packet.vertexCount, stride);
+
+        VertexCacheStats after = analyzeVertexCache(indices, packet.count, packet.vertexCount);
+
+        std::cout << "Mesh optimize: " << packet.count / 3 << " triangles, ACMR " << before.acmr << " -> "
+                  << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+    }
+}
+
+}
@@ -0,0 +1,36 @@
+#ifndef GL_MESH_OPTIMIZE_H
+#define GL_MESH_OPTIMIZE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "nit3dyne/graphics/mesh_data.h"
+
+namespace n3d {
+
+// Post-transform cache efficiency of an index list under a simulated FIFO cache
+struct VertexCacheStats {
+    float acmr = 0.f; // Average cache miss ratio, vertex shader invocations per triangle
+    float atvr = 0.f; // Average transformed vertex ratio, invocations per unique vertex
+};
+
+VertexCacheStats analyzeVertexCache(const uint32_t *indices, size_t indexCount, size_t vertexCount,
+                                    unsigned int cacheSize = 16);
+
+// Reorders triangles for vertex cache reuse (Forsyth, linear-speed vertex cache optimisation)
+void optimizeVertexCache(uint32_t *indices, size_t indexCount, size_t vertexCount);
+
+// Reorders clusters of cache-optimized triangles front to back from the outside in, to reduce overdraw
+void optimizeOverdraw(uint32_t *indices, size_t indexCount,
+                      const unsigned char *vertices, size_t vertexCount, size_t stride);
+
+// Reorders vertices in order of first use and remaps indices to match
+void optimizeVertexFetch(unsigned char *vertices, uint32_t *indices, size_t indexCount,
+                         size_t vertexCount, size_t stride);
+
+// Runs all three passes on every triangle packet of an imported mesh and reports cache stats
+void optimizeMesh(MeshData &data);
+
+}
+
+#endif // GL_MESH_OPTIMIZE_H
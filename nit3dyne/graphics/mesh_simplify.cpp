@@ -0,0 +1,339 @@
+#include "mesh_simplify.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+#include <glad/glad.h>
+
+#include "nit3dyne/graphics/mesh_optimize.h"
+
+namespace n3d {
+
+// Each LOD keeps at most this share of the previous level's triangles, or the chain ends
+const float LOD_MIN_REDUCTION = .8f;
+
+// Symmetric 4x4 error quadric, upper triangle
+struct Quadric {
+    double xx = 0, xy = 0, xz = 0, xw = 0;
+    double yy = 0, yz = 0, yw = 0;
+    double zz = 0, zw = 0;
+    double ww = 0;
+
+    void addPlane(const vec3 &n, double d) {
+        this->xx += n.x * n.x; this->xy += n.x * n.y; this->xz += n.x * n.z; this->xw += n.x * d;
+        this->yy += n.y * n.y; this->yz += n.y * n.z; this->yw += n.y * d;
+        this->zz += n.z * n.z; this->zw += n.z * d;
+        this->ww += d * d;
+    }
+
+    void add(const Quadric &q) {
+        this->xx += q.xx; this->xy += q.xy; this->xz += q.xz; this->xw += q.xw;
+        this->yy += q.yy; this->yz += q.yz; this->yw += q.yw;
+        this->zz += q.zz; this->zw += q.zw;
+        this->ww += q.ww;
+    }
+
+    // Sum of squared distances of p to the accumulated planes
+    double error(const vec3 &p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double e = this->xx * x * x + 2 * this->xy * x * y + 2 * this->xz * x * z + 2 * this->xw * x
+                   + this->yy * y * y + 2 * this->yz * y * z + 2 * this->yw * y
+                   + this->zz * z * z + 2 * this->zw * z
+                   + this->ww;
+        return std::max(e, 0.0);
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double cost;
+};
+
+static vec3 vertexPosition(const unsigned char *vertices, size_t stride, uint32_t index) {
+    vec3 position;
+    std::memcpy(&position, vertices + index * stride, sizeof(vec3));
+    return position;
+}
+
+// Squared distance of the attributes following the position, normal first in every layout
+static float attributeDistance(const unsigned char *vertices, size_t stride, uint32_t a, uint32_t b) {
+    size_t end = std::min(stride, (size_t) 32);
+    float distance = 0.f;
+    for (size_t offset = sizeof(vec3); offset + sizeof(float) <= end; offset += sizeof(float)) {
+        float fa, fb;
+        std::memcpy(&fa, vertices + a * stride + offset, sizeof(float));
+        std::memcpy(&fb, vertices + b * stride + offset, sizeof(float));
+        distance += (fa - fb) * (fa - fb);
+    }
+    return distance;
+}
+
+// Builds CSR lists of the live triangles around each vertex
+static void buildAdjacency(const std::vector<uint32_t> &corners, const std::vector<bool> &alive, size_t vertexCount,
+                           std::vector<uint32_t> &offsets, std::vector<uint32_t> &triangles) {
+    offsets.assign(vertexCount + 1, 0);
+    for (size_t t = 0; t < alive.size(); ++t) {
+        if (!alive[t]) continue;
+        for (int k = 0; k < 3; ++k)
+            ++offsets[corners[t * 3 + k] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+
+    triangles.resize(offsets[vertexCount]);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < alive.size(); ++t) {
+        if (!alive[t]) continue;
+        for (int k = 0; k < 3; ++k)
+            triangles[fill[corners[t * 3 + k]]++] = t;
+    }
+}
+
+std::vector<uint32_t> simplifyMesh(const uint32_t *indices, size_t indexCount,
+                                   const unsigned char *vertices, size_t vertexCount, size_t stride,
+                                   size_t targetIndexCount, float &error) {
+    size_t triangleCount = indexCount / 3;
+    error = 0.f;
+
+    // Weld by position, collapses happen between positions rather than vertices
+    std::vector<uint32_t> weld(vertexCount);
+    std::map<std::array<float, 3>, uint32_t> positions;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vec3 p = vertexPosition(vertices, stride, v);
+        weld[v] = positions.emplace(std::array<float, 3>{p.x, p.y, p.z}, v).first->second;
+    }
+
+    std::vector<uint32_t> corners(triangleCount * 3);
+    for (size_t i = 0; i < corners.size(); ++i)
+        corners[i] = weld[indices[i]];
+
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<bool> alive(triangleCount, true);
+    size_t liveCount = triangleCount;
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t *c = &corners[t * 3];
+        vec3 p0 = vertexPosition(vertices, stride, c[0]);
+        vec3 n = cross(vertexPosition(vertices, stride, c[1]) - p0, vertexPosition(vertices, stride, c[2]) - p0);
+        float length = glm::length(n);
+        if (c[0] == c[1] || c[1] == c[2] || c[2] == c[0] || length == 0.f) {
+            alive[t] = false;
+            --liveCount;
+            continue;
+        }
+
+        n /= length;
+        for (int k = 0; k < 3; ++k)
+            quadrics[c[k]].addPlane(n, -glm::dot(n, p0));
+    }
+
+    // Edges not shared by exactly two triangles are borders, their vertices never move
+    std::vector<bool> locked(vertexCount, false);
+    std::map<std::pair<uint32_t, uint32_t>, int> edgeUse;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!alive[t]) continue;
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = corners[t * 3 + k], b = corners[t * 3 + (k + 1) % 3];
+            ++edgeUse[std::make_pair(std::min(a, b), std::max(a, b))];
+        }
+    }
+    for (auto &edge : edgeUse) {
+        if (edge.second == 2) continue;
+        locked[edge.first.first] = true;
+        locked[edge.first.second] = true;
+    }
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint32_t> adjacencyOffset, adjacency;
+    std::vector<Collapse> candidates;
+    std::vector<bool> touched;
+    double maxCost = 0.0;
+
+    while (liveCount * 3 > targetIndexCount) {
+        buildAdjacency(corners, alive, vertexCount, adjacencyOffset, adjacency);
+
+        candidates.clear();
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (!alive[t]) continue;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = corners[t * 3 + k], b = corners[t * 3 + (k + 1) % 3];
+                Quadric q = quadrics[a];
+                q.add(quadrics[b]);
+
+                // Collapse onto an existing endpoint, whichever is cheaper and allowed
+                double toB = locked[a] ? -1.0 : q.error(vertexPosition(vertices, stride, b));
+                double toA = locked[b] ? -1.0 : q.error(vertexPosition(vertices, stride, a));
+                if (toB >= 0.0 && (toA < 0.0 || toB <= toA))
+                    candidates.push_back({a, b, toB});
+                else if (toA >= 0.0)
+                    candidates.push_back({b, a, toA});
+            }
+        }
+        if (candidates.empty()) break;
+
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse &l, const Collapse &r) {
+            return l.cost < r.cost;
+        });
+
+        // Only take the cheap end of this pass so costs can be refreshed before the expensive ones
+        size_t needed = liveCount - targetIndexCount / 3;
+        double costLimit = candidates[std::min(candidates.size() - 1, needed / 2)].cost * 1.5;
+
+        for (size_t v = 0; v < vertexCount; ++v)
+            remap[v] = v;
+        touched.assign(vertexCount, false);
+
+        size_t removed = 0;
+        size_t collapsed = 0;
+        for (const Collapse &collapse : candidates) {
+            if (removed >= needed) break;
+            if (collapse.cost > costLimit && collapsed > 0) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+
+            vec3 target = vertexPosition(vertices, stride, collapse.to);
+            bool flips = false;
+            size_t dying = 0;
+
+            for (uint32_t i = adjacencyOffset[collapse.from]; i < adjacencyOffset[collapse.from + 1]; ++i) {
+                uint32_t t = adjacency[i];
+                uint32_t c[3] = {remap[corners[t * 3]], remap[corners[t * 3 + 1]], remap[corners[t * 3 + 2]]};
+                if (c[0] == collapse.to || c[1] == collapse.to || c[2] == collapse.to) {
+                    ++dying;
+                    continue;
+                }
+
+                vec3 p[3], q[3];
+                for (int k = 0; k < 3; ++k) {
+                    p[k] = vertexPosition(vertices, stride, c[k]);
+                    q[k] = c[k] == collapse.from ? target : p[k];
+                }
+
+                // Reject collapses that turn a neighbouring triangle over
+                vec3 before = cross(p[1] - p[0], p[2] - p[0]);
+                vec3 after = cross(q[1] - q[0], q[2] - q[0]);
+                if (glm::dot(before, after) <= 0.f) {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips) continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            touched[collapse.from] = true;
+            touched[collapse.to] = true;
+
+            removed += dying;
+            ++collapsed;
+            maxCost = std::max(maxCost, collapse.cost);
+        }
+        if (collapsed == 0) break;
+
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (!alive[t]) continue;
+            uint32_t *c = &corners[t * 3];
+            for (int k = 0; k < 3; ++k)
+                c[k] = remap[c[k]];
+            if (c[0] == c[1] || c[1] == c[2] || c[2] == c[0]) {
+                alive[t] = false;
+                --liveCount;
+            }
+        }
+    }
+
+    // Members of each welded position, to resolve corners back to real vertices
+    std::vector<uint32_t> memberOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        ++memberOffset[weld[v] + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        memberOffset[v + 1] += memberOffset[v];
+    std::vector<uint32_t> members(vertexCount);
+    std::vector<uint32_t> fill(memberOffset.begin(), memberOffset.end() - 1);
+    for (size_t v = 0; v < vertexCount; ++v)
+        members[fill[weld[v]]++] = v;
+
+    std::vector<uint32_t> result;
+    result.reserve(liveCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!alive[t]) continue;
+
+        for (int k = 0; k < 3; ++k) {
+            uint32_t original = indices[t * 3 + k];
+            uint32_t position = corners[t * 3 + k];
+            if (weld[original] == position) {
+                result.push_back(original);
+                continue;
+            }
+
+            // Moved corner takes the vertex at its new position that looks most like it
+            uint32_t best = members[memberOffset[position]];
+            float bestDistance = attributeDistance(vertices, stride, original, best);
+            for (uint32_t i = memberOffset[position] + 1; i < memberOffset[position + 1]; ++i) {
+                float distance = attributeDistance(vertices, stride, original, members[i]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = members[i];
+                }
+            }
+            result.push_back(best);
+        }
+    }
+
+    error = (float) std::sqrt(maxCost);
+    return result;
+}
+
+void generateLods(MeshData &data) {
+    MeshHeader &header = data.header;
+    size_t packetCount = header.packetCount;
+    unsigned int stride = header.vertexStride;
+
+    for (uint32_t lod = 1; lod < MESH_MAX_LODS; ++lod) {
+        std::vector<DrawPacket> level(data.packets.end() - packetCount, data.packets.end());
+        std::vector<uint32_t> levelIndices;
+        float levelError = header.lodError[lod - 1];
+        size_t before = 0, after = 0;
+
+        for (DrawPacket &packet : level) {
+            before += packet.count;
+            if (packet.mode != GL_TRIANGLES || packet.count < 3) {
+                after += packet.count;
+                continue;
+            }
+
+            const uint32_t *indices = data.indices.data() + packet.offset / sizeof(uint32_t);
+            const unsigned char *vertices = data.vertices.data() + (size_t) packet.baseVertex * stride;
+
+            float error;
+            std::vector<uint32_t> simplified = simplifyMesh(
+                    indices, packet.count, vertices, packet.vertexCount, stride, packet.count / 6 * 3, error
+            );
+            optimizeVertexCache(simplified.data(), simplified.size(), packet.vertexCount);
+
+            packet.offset = (data.indices.size() + levelIndices.size()) * sizeof(uint32_t);
+            packet.count = simplified.size();
+            levelIndices.insert(levelIndices.end(), simplified.begin(), simplified.end());
+
+            levelError = std::max(levelError, error);
+            after += packet.count;
+        }
+
+        // Simplification stalled, e.g. only locked borders left
+        if (before == 0 || after > before * LOD_MIN_REDUCTION) break;
+
+        data.packets.insert(data.packets.end(), level.begin(), level.end());
+        data.indices.insert(data.indices.end(), levelIndices.begin(), levelIndices.end());
+        header.lodError[lod] = levelError;
+        header.lodCount = lod + 1;
+
+        std::cout << "Mesh LOD " << lod << ": " << before / 3 << " -> " << after / 3 << " triangles, error "
+                  << levelError << std::endl;
+    }
+}
+
+}
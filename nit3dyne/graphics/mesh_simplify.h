@@ -0,0 +1,27 @@
+#ifndef GL_MESH_SIMPLIFY_H
+#define GL_MESH_SIMPLIFY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "nit3dyne/graphics/mesh_data.h"
+
+namespace n3d {
+
+/*
+ * Quadric error edge collapse (Garland-Heckbert) over an indexed triangle list.
+ * Vertices are welded by position so attribute seams collapse together, corners are then
+ * resolved to the vertex of the target position with the closest attributes.
+ * Border vertices are locked. error receives the largest collapse error, in mesh units.
+ */
+std::vector<uint32_t> simplifyMesh(const uint32_t *indices, size_t indexCount,
+                                   const unsigned char *vertices, size_t vertexCount, size_t stride,
+                                   size_t targetIndexCount, float &error);
+
+// Appends simplified copies of every packet as LODs 1..n, halving the triangle count per level
+void generateLods(MeshData &data);
+
+}
+
+#endif // GL_MESH_SIMPLIFY_H
@@ -2,23 +2,12 @@
 
 namespace n3d {
 
-MeshStatic::MeshStatic(const std::string &resourceName) : Mesh(resourceName, MeshType::STATIC) {
-    this->bindModel();
-}
-
-void MeshStatic::bindModel() {
-    glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
+MeshStatic::MeshStatic(const std::string &resourceName) : MeshStatic(resourceName, *decode(resourceName)) {}
 
-    std::map<int, unsigned int> VBOs;
+MeshStatic::MeshStatic(const std::string &resourceName, Source &source) : Mesh(MeshType::STATIC, source) {}
 
-    this->bindMesh(this->gltf.meshes.front(), VBOs);
-
-    // Cleanup
-    glBindVertexArray(0);
-    for (size_t i = 0; i < VBOs.size(); ++i) {
-        glDeleteBuffers(1, &VBOs[i]);
-    }
+std::unique_ptr<Mesh::Source> MeshStatic::decode(const std::string &resourceName) {
+    return Mesh::decode(resourceName, MeshType::STATIC, false);
 }
 
-}
\ No newline at end of file
+}
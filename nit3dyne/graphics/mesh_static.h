@@ -8,11 +8,10 @@ namespace n3d{
 class MeshStatic : public Mesh {
 public:
     explicit MeshStatic(const std::string &resourceName);
+    MeshStatic(const std::string &resourceName, Source &source);
     ~MeshStatic() override = default;
 
-private:
-    void bindModel();
-
+    static std::unique_ptr<Source> decode(const std::string &resourceName);
 };
 
 }
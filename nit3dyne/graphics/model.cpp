@@ -1,5 +1,10 @@
 #include "model.h"
 
+#include <algorithm>
+
+#include "nit3dyne/core/display.h"
+#include "nit3dyne/core/profiler.h"
+
 namespace n3d {
 
 Model::Model(const std::shared_ptr<Mesh> mesh, const std::shared_ptr<Texture> texture) :
@@ -9,6 +14,12 @@ Model::Model(const std::shared_ptr<Mesh> mesh, const std::shared_ptr<Texture> te
 Model::~Model() = default;
 
 void Model::draw(Shader &shader, const mat4 &perspective, const mat4 &view) {
+    N3D_PROFILE_SCOPE("Model::draw");
+
+    if (!this->isVisible(Frustum(perspective * view))) return;
+
+    int lod = this->selectLod(perspective, view);
+
     shader.use();
     shader.attachMaterial(*this->material);
 
@@ -16,24 +27,31 @@ void Model::draw(Shader &shader, const mat4 &perspective, const mat4 &view) {
     mat4 modelView = view * this->modelMat;
     mat3 normalMat = inverse(transpose(mat3(modelView)));
 
-    shader.setUniform("mvp", mvp);
-    shader.setUniform("modelView", modelView);
-    shader.setUniform("normalMat", normalMat);
+    shader.setTransform(mvp, modelView, normalMat);
 
     if (this->mesh->meshType != MeshType::COLORED) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, this->texture->handle);
+        GLState::bindTexture(GL_TEXTURE_2D, this->texture->handle);
     }
 
     if (this->mesh->meshType == MeshType::ANIMATED) {
-        dynamic_cast<MeshAnimated *>(this->mesh.get())->draw(shader);
+        dynamic_cast<MeshAnimated *>(this->mesh.get())->draw(shader, lod);
     } else if (this->mesh->meshType == MeshType::STATIC) {
-        dynamic_cast<MeshStatic *>(this->mesh.get())->draw(shader);
+        dynamic_cast<MeshStatic *>(this->mesh.get())->draw(shader, lod);
     } else if (this->mesh->meshType == MeshType::COLORED) {
-        dynamic_cast<MeshColored *>(this->mesh.get())->draw(shader);
+        dynamic_cast<MeshColored *>(this->mesh.get())->draw(shader, lod);
     }
 }
 
+void Model::submit(RenderQueue &queue, Shader &shader, const mat4 &perspective, const mat4 &view, RenderPass pass) {
+    int lod = this->selectLod(perspective, view);
+    queue.submit(shader, *this->material, this->texture.get(), *this->mesh, this->modelMat, lod, pass);
+}
+
+void Model::record(CommandList &list, Shader &shader, RenderPass pass) {
+    int lod = this->selectLod(list.getPerspective(), list.getView());
+    list.record(shader, *this->material, this->texture.get(), *this->mesh, this->modelMat, lod, pass);
+}
+
 void Model::translate(float x, float y, float z) {
     this->modelMat = n3d::translate(this->modelMat, vec3(x, y, z));
 }
@@ -48,6 +66,46 @@ void Model::rotate(float deg, float x, float y, float z, bool normalize) {
                                  normalize ? n3d::normalize(vec3(x, y, z)) : vec3(x, y, z));
 }
 
+bool Model::isVisible(const Frustum &frustum) const {
+    return frustum.containsBounds(
+            this->mesh->boundsMin, this->mesh->boundsMax, this->mesh->sphereCenter, this->mesh->sphereRadius,
+            this->modelMat
+    );
+}
+
+void Model::addOccluder(OcclusionBuffer &buffer) const {
+    if (this->mesh->occluder) buffer.addOccluder(*this->mesh->occluder, this->modelMat);
+}
+
+int Model::selectLod(const mat4 &perspective, const mat4 &view) {
+    if (this->mesh->lodCount <= 1) return this->lod = 0;
+
+    vec3 center = view * this->modelMat * vec4(this->mesh->sphereCenter, 1.f);
+    float scale = std::max({
+            glm::length(vec3(this->modelMat[0])),
+            glm::length(vec3(this->modelMat[1])),
+            glm::length(vec3(this->modelMat[2]))
+    });
+
+    // Camera inside the bounds, full detail
+    float distance = glm::length(center) - this->mesh->sphereRadius * scale;
+    if (distance <= 0.f) return this->lod = 0;
+
+    // Virtual pixels per world unit at the given distance, the scene is rendered at the virtual resolution
+    float pixelsPerUnit = perspective[1][1] * Display::viewPortVirtual.second * .5f / distance;
+
+    int selected = 0;
+    for (int level = this->mesh->lodCount - 1; level > 0; --level) {
+        float threshold = lodPixelError * (level > this->lod ? 1.f - lodHysteresis : 1.f);
+        if (this->mesh->lodError[level] * scale * pixelsPerUnit <= threshold) {
+            selected = level;
+            break;
+        }
+    }
+
+    return this->lod = selected;
+}
+
 void Model::setMaterial(const Material &material) {
     this->material = &material;
 }
@@ -7,21 +7,37 @@
 #include "nit3dyne/graphics/mesh_static.h"
 #include "nit3dyne/graphics/mesh_animated.h"
 #include "nit3dyne/graphics/mesh_colored.h"
+#include "nit3dyne/graphics/render_queue.h"
 #include "nit3dyne/graphics/shader.h"
 #include "nit3dyne/graphics/texture.h"
 #include "nit3dyne/core/math.h"
+#include "nit3dyne/camera/frustum.h"
+#include "nit3dyne/graphics/gl_state.h"
 
 namespace n3d {
 
 class Model {
 public:
+    // A level is used while its geometric error projects to at most this many virtual pixels
+    inline static float lodPixelError = 1.f;
+    // Fraction the error has to drop below the threshold before switching to a coarser level
+    inline static float lodHysteresis = .25f;
+
     // TODO Add another constructor with a default material
     explicit Model(std::shared_ptr<Mesh> mesh, std::shared_ptr<Texture> texture);
 
     ~Model();
 
+    // Draws immediately, prefer submit so draws can be sorted by state
     void draw(Shader &shader, const mat4 &perspective, const mat4 &view);
 
+    // Queues the draw with the LOD for the queue's camera, perspective and view must match RenderQueue::begin
+    void submit(RenderQueue &queue, Shader &shader, const mat4 &perspective, const mat4 &view,
+                RenderPass pass = PASS_OPAQUE);
+
+    // Same as submit from any thread, the LOD is picked for the list's camera. Record each model on one list only.
+    void record(CommandList &list, Shader &shader, RenderPass pass = PASS_OPAQUE);
+
     void setMaterial(const Material &material);
 
     void translate(float x, float y, float z);
@@ -30,11 +46,21 @@ public:
 
     void rotate(float deg, float x, float y, float z, bool normalize = true);
 
+    // Tests the mesh bounds under modelMat
+    bool isVisible(const Frustum &frustum) const;
+
+    // Draws the mesh's occluder into buffer, for large models that hide others
+    void addOccluder(OcclusionBuffer &buffer) const;
+
+    // Picks the coarsest LOD whose error is invisible at the virtual resolution, updates and returns lod
+    int selectLod(const mat4 &perspective, const mat4 &view);
+
     mat4 modelMat;
 
     std::shared_ptr<Mesh> mesh;
     std::shared_ptr<Texture> texture;
     const Material *material = &Materials::basic;
+    int lod = 0;
 };
 
 }
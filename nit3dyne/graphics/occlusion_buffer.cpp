@@ -0,0 +1,290 @@
+#include "occlusion_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <glad/glad.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace n3d {
+
+const int TILE_SIZE = 8;
+
+// Clip space w below this counts as touching the eye
+const float NEAR_W = 1e-4f;
+
+void buildOccluder(const MeshHeader &header, const DrawPacket *packets, const unsigned char *vertices,
+                   const uint32_t *indices, float maxError, OccluderMesh &out) {
+    out.positions.clear();
+    out.indices.clear();
+
+    uint32_t lod = 0;
+    for (uint32_t level = 1; level < header.lodCount; ++level) {
+        if (header.lodError[level] <= header.sphereRadius * maxError) lod = level;
+    }
+
+    // Only vertices the chosen level references, every vertex type starts with its position
+    std::vector<uint32_t> remap(header.vertexCount, UINT32_MAX);
+    for (uint32_t i = 0; i < header.packetCount; ++i) {
+        const DrawPacket &packet = packets[lod * header.packetCount + i];
+        if (packet.mode != GL_TRIANGLES || packet.indexType != GL_UNSIGNED_INT) continue;
+
+        const uint32_t *packetIndices = indices + packet.offset / sizeof(uint32_t);
+        for (uint32_t j = 0; j + 2 < packet.count; j += 3) {
+            // Index values aren't validated with the header, drop triangles a stale file points past the vertices
+            uint64_t triangle[3];
+            for (int k = 0; k < 3; ++k)
+                triangle[k] = (uint64_t) packetIndices[j + k] + packet.baseVertex;
+            if (std::any_of(triangle, triangle + 3, [&header](uint64_t v) { return v >= header.vertexCount; }))
+                continue;
+
+            for (uint64_t vertex : triangle) {
+                if (remap[vertex] == UINT32_MAX) {
+                    remap[vertex] = (uint32_t) out.positions.size();
+                    out.positions.push_back(*(const vec3 *) (vertices + vertex * header.vertexStride));
+                }
+                out.indices.push_back(remap[vertex]);
+            }
+        }
+    }
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height) {
+    // Whole tiles, which also keeps rows a multiple of the SIMD width
+    this->tilesX = std::max(1, (width + TILE_SIZE - 1) / TILE_SIZE);
+    this->tilesY = std::max(1, (height + TILE_SIZE - 1) / TILE_SIZE);
+    this->width = this->tilesX * TILE_SIZE;
+    this->height = this->tilesY * TILE_SIZE;
+
+    // A couple of bands per thread evens out uneven occluder coverage
+    int threads = (int) std::max(std::thread::hardware_concurrency(), 1u);
+    int bandCount = std::min(this->tilesY, threads * 2);
+    int bandTiles = (this->tilesY + bandCount - 1) / bandCount;
+    this->bandRows = bandTiles * TILE_SIZE;
+    this->bands.resize((this->tilesY + bandTiles - 1) / bandTiles);
+
+    this->depth.assign((size_t) this->width * this->height, 1.f);
+    this->tileMax.assign((size_t) this->tilesX * this->tilesY, 1.f);
+}
+
+void OcclusionBuffer::begin(const mat4 &viewProjection) {
+    this->viewProjection = viewProjection;
+    std::fill(this->depth.begin(), this->depth.end(), 1.f);
+    std::fill(this->tileMax.begin(), this->tileMax.end(), 1.f);
+    for (auto &band : this->bands)
+        band.clear();
+
+    this->visible = 0;
+    this->occluded = 0;
+}
+
+void OcclusionBuffer::addOccluder(const OccluderMesh &occluder, const mat4 &modelMat) {
+    mat4 mvp = this->viewProjection * modelMat;
+
+    this->clipPositions.resize(occluder.positions.size());
+    for (size_t i = 0; i < occluder.positions.size(); ++i)
+        this->clipPositions[i] = mvp * vec4(occluder.positions[i], 1.f);
+
+    for (size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+        ScreenTriangle triangle;
+        bool clipped = false;
+
+        for (int corner = 0; corner < 3; ++corner) {
+            const vec4 &clip = this->clipPositions[occluder.indices[i + corner]];
+
+            // Triangles crossing the near plane are dropped, an occluder can only hide less
+            if (clip.w < NEAR_W || clip.z < -clip.w) {
+                clipped = true;
+                break;
+            }
+
+            vec3 ndc = vec3(clip) / clip.w;
+            triangle.v[corner] = vec3(
+                    (ndc.x * .5f + .5f) * this->width,
+                    (ndc.y * .5f + .5f) * this->height,
+                    ndc.z * .5f + .5f
+            );
+        }
+        if (clipped) continue;
+
+        const vec3 &a = triangle.v[0];
+        const vec3 &b = triangle.v[1];
+        const vec3 &c = triangle.v[2];
+
+        // Counter clockwise is front facing, y points up
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (area <= 0.f) continue;
+
+        float minX = std::min({a.x, b.x, c.x});
+        float maxX = std::max({a.x, b.x, c.x});
+        float minY = std::min({a.y, b.y, c.y});
+        float maxY = std::max({a.y, b.y, c.y});
+        if (maxX < 0.f || maxY < 0.f || minX >= this->width || minY >= this->height) continue;
+
+        int firstBand = std::max(0, (int) minY / this->bandRows);
+        int lastBand = std::min((int) this->bands.size() - 1, (int) maxY / this->bandRows);
+        for (int band = firstBand; band <= lastBand; ++band)
+            this->bands[band].push_back(triangle);
+    }
+}
+
+void OcclusionBuffer::rasterize() {
+    // The calling thread takes bands too instead of idling
+    Loader::parallelFor(this->bands.size(), [this](size_t band) { this->rasterizeBand((int) band); });
+}
+
+void OcclusionBuffer::rasterizeBand(int band) {
+    int rowBegin = band * this->bandRows;
+    int rowEnd = std::min(rowBegin + this->bandRows, this->height);
+
+    for (const ScreenTriangle &triangle : this->bands[band])
+        this->rasterizeTriangle(triangle, rowBegin, rowEnd);
+
+    for (int tileY = rowBegin / TILE_SIZE; tileY < rowEnd / TILE_SIZE; ++tileY) {
+        for (int tileX = 0; tileX < this->tilesX; ++tileX) {
+            float farthest = 0.f;
+            for (int y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; ++y) {
+                const float *row = this->depth.data() + (size_t) y * this->width + tileX * TILE_SIZE;
+                farthest = std::max(farthest, *std::max_element(row, row + TILE_SIZE));
+            }
+            this->tileMax[tileY * this->tilesX + tileX] = farthest;
+        }
+    }
+}
+
+void OcclusionBuffer::rasterizeTriangle(const ScreenTriangle &triangle, int rowBegin, int rowEnd) {
+    const vec3 &a = triangle.v[0];
+    const vec3 &b = triangle.v[1];
+    const vec3 &c = triangle.v[2];
+
+    // Edge functions e = A * x + B * y + C, positive inside. Edge i is opposite corner i.
+    const vec3 *from[3] = {&b, &c, &a};
+    const vec3 *to[3] = {&c, &a, &b};
+    float edgeA[3], edgeB[3], edgeC[3];
+    for (int i = 0; i < 3; ++i) {
+        edgeA[i] = from[i]->y - to[i]->y;
+        edgeB[i] = to[i]->x - from[i]->x;
+        edgeC[i] = -(edgeA[i] * from[i]->x + edgeB[i] * from[i]->y);
+    }
+
+    // Depth plane from the barycentric weights of b and c
+    float area = edgeA[0] * a.x + edgeB[0] * a.y + edgeC[0];
+    float dzB = (b.z - a.z) / area;
+    float dzC = (c.z - a.z) / area;
+    float depthA = dzB * edgeA[1] + dzC * edgeA[2];
+    float depthB = dzB * edgeB[1] + dzC * edgeB[2];
+    float depthC = a.z + dzB * edgeC[1] + dzC * edgeC[2];
+
+    int x0 = std::max(0, (int) std::floor(std::min({a.x, b.x, c.x}))) & ~3;
+    int x1 = std::min(this->width - 1, (int) std::ceil(std::max({a.x, b.x, c.x})));
+    int y0 = std::max(rowBegin, (int) std::floor(std::min({a.y, b.y, c.y})));
+    int y1 = std::min(rowEnd - 1, (int) std::ceil(std::max({a.y, b.y, c.y})));
+
+#if defined(__SSE2__)
+    const __m128 offsets = _mm_setr_ps(.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 stepA[3];
+    for (int i = 0; i < 3; ++i)
+        stepA[i] = _mm_set1_ps(edgeA[i]);
+    __m128 stepDepth = _mm_set1_ps(depthA);
+
+    for (int y = y0; y <= y1; ++y) {
+        float centerY = y + .5f;
+        __m128 rowEdge[3];
+        for (int i = 0; i < 3; ++i)
+            rowEdge[i] = _mm_set1_ps(edgeB[i] * centerY + edgeC[i]);
+        __m128 rowDepth = _mm_set1_ps(depthB * centerY + depthC);
+
+        float *row = this->depth.data() + (size_t) y * this->width;
+        for (int x = x0; x <= x1; x += 4) {
+            __m128 centerX = _mm_add_ps(_mm_set1_ps((float) x), offsets);
+            __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[0], centerX), rowEdge[0]), zero);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[1], centerX), rowEdge[1]), zero));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[2], centerX), rowEdge[2]), zero));
+            if (_mm_movemask_ps(inside) == 0) continue;
+
+            __m128 previous = _mm_loadu_ps(row + x);
+            __m128 nearest = _mm_min_ps(previous, _mm_add_ps(_mm_mul_ps(stepDepth, centerX), rowDepth));
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+        }
+    }
+#else
+    for (int y = y0; y <= y1; ++y) {
+        float centerY = y + .5f;
+        float *row = this->depth.data() + (size_t) y * this->width;
+        for (int x = x0; x <= x1; ++x) {
+            float centerX = x + .5f;
+            bool inside = true;
+            for (int i = 0; i < 3; ++i)
+                inside = inside && edgeA[i] * centerX + edgeB[i] * centerY + edgeC[i] >= 0.f;
+            if (!inside) continue;
+
+            row[x] = std::min(row[x], depthA * centerX + depthB * centerY + depthC);
+        }
+    }
+#endif
+}
+
+bool OcclusionBuffer::test(const vec3 &min, const vec3 &max) {
+    vec2 screenMin(INFINITY);
+    vec2 screenMax(-INFINITY);
+    float nearest = INFINITY;
+
+    for (int corner = 0; corner < 8; ++corner) {
+        vec3 position(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z);
+        vec4 clip = this->viewProjection * vec4(position, 1.f);
+
+        // Boxes reaching the near plane are never occluded
+        if (clip.w < NEAR_W || clip.z < -clip.w) {
+            ++this->visible;
+            return true;
+        }
+
+        vec3 ndc = vec3(clip) / clip.w;
+        vec2 screen((ndc.x * .5f + .5f) * this->width, (ndc.y * .5f + .5f) * this->height);
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+        nearest = std::min(nearest, ndc.z * .5f + .5f);
+    }
+
+    int x0 = std::max(0, (int) std::floor(screenMin.x));
+    int x1 = std::min(this->width - 1, (int) std::ceil(screenMax.x));
+    int y0 = std::max(0, (int) std::floor(screenMin.y));
+    int y1 = std::min(this->height - 1, (int) std::ceil(screenMax.y));
+
+    // Off screen boxes are the frustum's call
+    if (x0 > x1 || y0 > y1) {
+        ++this->visible;
+        return true;
+    }
+
+    for (int tileY = y0 / TILE_SIZE; tileY <= y1 / TILE_SIZE; ++tileY) {
+        for (int tileX = x0 / TILE_SIZE; tileX <= x1 / TILE_SIZE; ++tileX) {
+            // Everything in the tile is in front of the box
+            if (this->tileMax[tileY * this->tilesX + tileX] < nearest) continue;
+
+            int rowBegin = std::max(y0, tileY * TILE_SIZE);
+            int rowEnd = std::min(y1, (tileY + 1) * TILE_SIZE - 1);
+            int columnBegin = std::max(x0, tileX * TILE_SIZE);
+            int columnEnd = std::min(x1, (tileX + 1) * TILE_SIZE - 1);
+
+            for (int y = rowBegin; y <= rowEnd; ++y) {
+                const float *row = this->depth.data() + (size_t) y * this->width;
+                for (int x = columnBegin; x <= columnEnd; ++x) {
+                    if (row[x] >= nearest) {
+                        ++this->visible;
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    ++this->occluded;
+    return false;
+}
+
+}
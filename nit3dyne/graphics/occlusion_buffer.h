@@ -0,0 +1,80 @@
+#ifndef GL_OCCLUSION_BUFFER_H
+#define GL_OCCLUSION_BUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/core/loader.h"
+#include "nit3dyne/graphics/mesh_data.h"
+
+namespace n3d {
+
+// Positions and triangles of a simplified mesh, drawn into the occlusion buffer
+struct OccluderMesh {
+    std::vector<vec3> positions;
+    std::vector<uint32_t> indices;
+};
+
+// Takes the coarsest LOD whose error stays within maxError of the bounding radius, triangles only
+void buildOccluder(const MeshHeader &header, const DrawPacket *packets, const unsigned char *vertices,
+                   const uint32_t *indices, float maxError, OccluderMesh &out);
+
+/*
+ * Software depth buffer for occlusion culling, a fraction of the virtual resolution.
+ * Per frame: begin(), addOccluder() for large closed meshes, rasterize(), then test() object bounds.
+ * Rows are split in bands rasterized on worker threads with SSE, each band also builds the
+ * farthest depth of its 8x8 tiles so most tests never touch pixels.
+ */
+class OcclusionBuffer {
+public:
+    // Occluders are simplified until this share of their bounding radius
+    inline static float occluderError = .02f;
+
+    // Rasterizes on the Loader workers
+    OcclusionBuffer(int width, int height);
+
+    void begin(const mat4 &viewProjection);
+
+    // Transforms and bins the occluder's front facing triangles, render thread
+    void addOccluder(const OccluderMesh &occluder, const mat4 &modelMat);
+
+    // Rasterizes all binned triangles, returns once every band is done
+    void rasterize();
+
+    // False if the world space box is behind the occluders
+    bool test(const vec3 &min, const vec3 &max);
+
+    int getWidth() const { return this->width; }
+
+    int getHeight() const { return this->height; }
+
+    // Results of test() since begin
+    unsigned int visible = 0;
+    unsigned int occluded = 0;
+
+private:
+    struct ScreenTriangle {
+        vec3 v[3]; // Pixels, depth in [0, 1]
+    };
+
+    void rasterizeBand(int band);
+
+    void rasterizeTriangle(const ScreenTriangle &triangle, int rowBegin, int rowEnd);
+
+    int width;
+    int height;
+    int tilesX;
+    int tilesY;
+    int bandRows; // Pixel rows per band, a multiple of the tile size
+
+    mat4 viewProjection = mat4(1.f);
+    std::vector<float> depth;
+    std::vector<float> tileMax; // Farthest depth per tile
+    std::vector<std::vector<ScreenTriangle>> bands;
+    std::vector<vec4> clipPositions; // Scratch for addOccluder
+};
+
+}
+
+#endif // GL_OCCLUSION_BUFFER_H
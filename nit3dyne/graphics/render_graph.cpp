@@ -0,0 +1,327 @@
+#include "render_graph.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace n3d {
+
+static const float QUAD_VERTICES[] = {
+    -1.0f,  1.0f,    0.0f, 1.0f,
+    -1.0f, -1.0f,    0.0f, 0.0f,
+    1.0f,  -1.0f,    1.0f, 0.0f,
+    -1.0f,  1.0f,    0.0f, 1.0f,
+    1.0f,  -1.0f,    1.0f, 0.0f,
+    1.0f,   1.0f,    1.0f, 1.0f
+};
+
+RenderGraph::RenderGraph() {
+    this->targets.push_back({0, 0, 0, 0, false, -1, 0, 0});
+
+    glGenVertexArrays(1, &this->quadVao);
+    glGenBuffers(1, &this->quadVbo);
+
+    GLState::bindVertexArray(this->quadVao);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, this->quadVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_VERTICES), &QUAD_VERTICES, GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) (2 * sizeof(float)));
+
+    GLState::bindVertexArray(0);
+}
+
+RenderGraph::~RenderGraph() {
+    this->releasePhysicals();
+    for (auto &pProgram : this->programs)
+        delete pProgram.second;
+
+    GLState::deleteVertexArrays(1, &this->quadVao);
+    GLState::deleteBuffers(1, &this->quadVbo);
+}
+
+void RenderGraph::setBackbufferSize(int width, int height) {
+    this->backbuffer = std::make_pair(width, height);
+}
+
+RenderGraph::Target RenderGraph::importTarget(unsigned int framebuffer, unsigned int texture, int width, int height) {
+    this->targets.push_back({framebuffer, texture, width, height, false, -1, width, height});
+    this->dirty = true;
+    return (Target) this->targets.size() - 1;
+}
+
+RenderGraph::Target RenderGraph::createTarget(int width, int height) {
+    this->targets.push_back({0, 0, width, height, true, -1, width, height});
+    this->dirty = true;
+    return (Target) this->targets.size() - 1;
+}
+
+void RenderGraph::setRegion(Target target, int width, int height) {
+    if (target == BACKBUFFER) return;
+
+    TargetInfo &info = this->targets[target];
+    info.regionWidth = std::min(std::max(width, 1), info.width);
+    info.regionHeight = std::min(std::max(height, 1), info.height);
+}
+
+void RenderGraph::addPass(const std::string &name, const std::string &effectPath, Target input, Target output,
+                          bool pointwise) {
+    if (input == BACKBUFFER) {
+        std::cout << "Render graph error: pass " << name << " reads the backbuffer" << std::endl;
+        return;
+    }
+
+    this->passes.push_back({name, effectPath, input, output, pointwise});
+    this->dirty = true;
+}
+
+void RenderGraph::setTexture(const std::string &sampler, const Texture &texture) {
+    for (auto &pSampler : this->samplers) {
+        if (pSampler.first == sampler) {
+            pSampler.second = &texture;
+            return;
+        }
+    }
+
+    // New samplers take a unit the compiled programs do not know yet
+    this->samplers.emplace_back(sampler, &texture);
+    this->dirty = true;
+}
+
+void RenderGraph::compile() {
+    this->releasePhysicals();
+    this->steps.clear();
+    this->fused = 0;
+
+    std::vector<int> readers(this->targets.size(), 0);
+    for (const Pass &pass : this->passes)
+        ++readers[pass.input];
+
+    // A pointwise pass joins the draw writing its input when that target exists only between the two
+    for (size_t i = 0; i < this->passes.size(); ++i) {
+        const Pass &pass = this->passes[i];
+        const TargetInfo &input = this->targets[pass.input];
+
+        Step *writer = nullptr;
+        for (auto step = this->steps.rbegin(); step != this->steps.rend(); ++step) {
+            if (step->output == pass.input) {
+                writer = &*step;
+                break;
+            }
+        }
+
+        if (writer != nullptr && pass.pointwise && input.transient && readers[pass.input] == 1) {
+            writer->passes.push_back(i);
+            writer->output = pass.output;
+            writer->snap = pass.input;
+            ++this->fused;
+            continue;
+        }
+
+        this->steps.push_back({{i}, pass.input, pass.output, BACKBUFFER, nullptr, -1, -1});
+    }
+
+    // Targets hold their texture from the draw writing them to the last draw reading them
+    std::vector<int> lastRead(this->targets.size(), -1);
+    for (size_t s = 0; s < this->steps.size(); ++s)
+        lastRead[this->steps[s].input] = (int) s;
+
+    std::vector<bool> inUse;
+    for (size_t s = 0; s < this->steps.size(); ++s) {
+        const TargetInfo &input = this->targets[this->steps[s].input];
+        if (input.transient && input.physical < 0)
+            std::cout << "Render graph error: a target is read before any pass writes it" << std::endl;
+
+        TargetInfo &output = this->targets[this->steps[s].output];
+        if (output.transient) {
+            int physical = -1;
+            for (size_t p = 0; p < this->physicals.size(); ++p) {
+                const Physical &candidate = this->physicals[p];
+                if (!inUse[p] && candidate.width == output.width && candidate.height == output.height) {
+                    physical = (int) p;
+                    break;
+                }
+            }
+
+            if (physical < 0) {
+                Physical created{0, 0, output.width, output.height};
+                glGenFramebuffers(1, &created.framebuffer);
+                glGenTextures(1, &created.texture);
+
+                GLState::bindFramebuffer(created.framebuffer);
+                GLState::bindTexture(GL_TEXTURE_2D, created.texture);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, output.width, output.height, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                             nullptr);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, created.texture, 0);
+
+                if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                    std::cout << "Render graph error: target framebuffer is not complete" << std::endl;
+
+                physical = (int) this->physicals.size();
+                this->physicals.push_back(created);
+                inUse.push_back(false);
+            }
+
+            output.physical = physical;
+            inUse[physical] = true;
+        }
+
+        // Free after the draw, a draw never writes the texture it reads
+        for (Target released : {this->steps[s].input, this->steps[s].output}) {
+            const TargetInfo &target = this->targets[released];
+            if (target.transient && target.physical >= 0 && lastRead[released] <= (int) s)
+                inUse[target.physical] = false;
+        }
+    }
+
+    for (Step &step : this->steps) {
+        step.shader = this->program(step);
+        if (step.shader == nullptr) continue;
+        step.uvScale = glGetUniformLocation(step.shader->handle, "uvScale");
+        step.snapSize = glGetUniformLocation(step.shader->handle, "snapSize");
+    }
+
+    for (Step &step : this->steps) {
+        step.label = "post ";
+        for (size_t pass : step.passes)
+            step.label += (pass == step.passes.front() ? "" : "+") + this->passes[pass].name;
+    }
+
+    this->draws = (unsigned int) this->steps.size();
+    this->textures = (unsigned int) this->physicals.size();
+    this->dirty = false;
+}
+
+Shader *RenderGraph::program(const Step &step) {
+    bool copy = std::all_of(step.passes.begin(), step.passes.end(), [this](size_t pass) {
+        return this->passes[pass].effectPath.empty();
+    });
+    if (copy) return nullptr;
+
+    std::string source = "#version 330 core\n\nout vec4 fragColor;\n\nin vec2 texCoord;\n\nuniform sampler2D tex;\n";
+    source += "uniform vec2 uvScale;  // Region of tex in use\n";
+    source += "uniform vec2 snapSize; // Region of the fused away target\n\n";
+    source += "#include \"include/uniforms.glsl\"\n";
+
+    std::vector<std::string> included;
+    for (size_t pass : step.passes) {
+        const std::string &path = this->passes[pass].effectPath;
+        if (path.empty() || std::find(included.begin(), included.end(), path) != included.end()) continue;
+        source += "#include \"" + path + "\"\n";
+        included.push_back(path);
+    }
+
+    source += "\nvoid main() {\n";
+    if (step.snap != BACKBUFFER) {
+        // Centers of the fused away target's texels, effects see the uvs they would have unfused
+        source += "    vec2 uv = (floor(texCoord * snapSize) + 0.5) / snapSize * uvScale;\n";
+    } else {
+        source += "    vec2 uv = texCoord * uvScale;\n";
+    }
+    source += "    vec4 color = texture(tex, uv);\n";
+    for (size_t pass : step.passes) {
+        if (this->passes[pass].effectPath.empty()) continue;
+        source += "    color = " + this->passes[pass].name + "(color, uv);\n";
+    }
+    source += "    fragColor = color;\n}\n";
+
+    Shader *&shader = this->programs[source];
+    if (shader == nullptr) shader = Shader::fromSource("#include \"copy.vert\"\n", source);
+
+    // Units follow the sampler order, which can change between compiles
+    shader->use();
+    Shader::upload(glGetUniformLocation(shader->handle, "tex"), 0);
+    for (size_t i = 0; i < this->samplers.size(); ++i)
+        Shader::upload(glGetUniformLocation(shader->handle, this->samplers[i].first.c_str()), (int) i + 1);
+
+    return shader;
+}
+
+void RenderGraph::execute(GpuTimer *timer) {
+    if (this->dirty) this->compile();
+
+    // Full screen draws cover every pixel, blending and depth would only cost
+    GLState::disable(GL_DEPTH_TEST);
+    GLState::disable(GL_BLEND);
+
+    for (const Step &step : this->steps) {
+        Binding read = this->binding(step.input);
+        Binding draw = this->binding(step.output);
+        if (timer != nullptr) timer->begin(step.label);
+
+        if (step.shader == nullptr) {
+            GLState::bindFramebuffers(read.framebuffer, draw.framebuffer);
+            glBlitFramebuffer(0, 0, read.regionWidth, read.regionHeight, 0, 0, draw.regionWidth, draw.regionHeight,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            if (timer != nullptr) timer->end(step.label);
+            continue;
+        }
+
+        GLState::bindFramebuffer(draw.framebuffer);
+        GLState::viewport(0, 0, draw.regionWidth, draw.regionHeight);
+
+        step.shader->use();
+        Shader::upload(step.uvScale, vec2((float) read.regionWidth / (float) read.width,
+                                          (float) read.regionHeight / (float) read.height));
+        if (step.snap != BACKBUFFER) {
+            const TargetInfo &snap = this->targets[step.snap];
+            Shader::upload(step.snapSize, vec2((float) snap.regionWidth, (float) snap.regionHeight));
+        }
+        GLState::bindTexture(GL_TEXTURE_2D, read.texture, 0);
+        for (size_t i = 0; i < this->samplers.size(); ++i)
+            GLState::bindTexture(GL_TEXTURE_2D, this->samplers[i].second->handle, (GLuint) i + 1);
+
+        GLState::bindVertexArray(this->quadVao);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        if (timer != nullptr) timer->end(step.label);
+    }
+
+    // Back to the defaults set by Display::initGl
+    GLState::enable(GL_BLEND);
+    GLState::enable(GL_DEPTH_TEST);
+}
+
+void RenderGraph::clear() {
+    this->releasePhysicals();
+    this->passes.clear();
+    this->steps.clear();
+    this->targets.resize(1);
+    this->dirty = true;
+}
+
+RenderGraph::Binding RenderGraph::binding(Target target) const {
+    if (target == BACKBUFFER) {
+        int width = this->backbuffer.first, height = this->backbuffer.second;
+        return {0, 0, width, height, width, height};
+    }
+
+    const TargetInfo &info = this->targets[target];
+    Binding out{info.framebuffer, info.texture, info.width, info.height, info.regionWidth, info.regionHeight};
+    if (info.transient) {
+        out.framebuffer = 0;
+        out.texture = 0;
+        if (info.physical >= 0) {
+            out.framebuffer = this->physicals[info.physical].framebuffer;
+            out.texture = this->physicals[info.physical].texture;
+        }
+    }
+    return out;
+}
+
+void RenderGraph::releasePhysicals() {
+    for (Physical &physical : this->physicals) {
+        GLState::deleteFramebuffers(1, &physical.framebuffer);
+        GLState::deleteTextures(1, &physical.texture);
+    }
+    this->physicals.clear();
+
+    for (TargetInfo &target : this->targets)
+        target.physical = -1;
+}
+
+}
@@ -0,0 +1,156 @@
+#ifndef GL_RENDER_GRAPH_H
+#define GL_RENDER_GRAPH_H
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <entt/core/hashed_string.hpp>
+
+#include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/texture.h"
+#include "nit3dyne/graphics/gl_state.h"
+#include "nit3dyne/graphics/gpu_timer.h"
+
+namespace n3d {
+
+/*
+ * Full screen passes declared by their input and output targets, run in declaration order.
+ * compile() folds each pointwise pass into the pass writing its input when nothing else reads
+ * that target, so a chain of effects becomes one generated shader and one draw. Transient targets
+ * left over share textures with targets whose lifetimes do not overlap. A pass that only copies
+ * becomes a blit.
+ *
+ * Effects are GLSL files under shaders/ defining vec4 <name>(vec4 color, vec2 uv). The generated
+ * shader provides the input as sampler2D tex and includes the FrameData block.
+ *
+ * Targets can be used in part through setRegion, e.g. for dynamic resolution; draws then cover and
+ * sample only the regions, nothing is reallocated.
+ */
+class RenderGraph {
+public:
+    typedef int Target;
+
+    inline static const Target BACKBUFFER = 0;
+
+    RenderGraph();
+
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph &) = delete;
+    RenderGraph &operator=(const RenderGraph &) = delete;
+
+    void setBackbufferSize(int width, int height);
+
+    // Framebuffer and color texture owned elsewhere, like the scene target
+    Target importTarget(unsigned int framebuffer, unsigned int texture, int width, int height);
+
+    // Color only, allocated by compile
+    Target createTarget(int width, int height);
+
+    // Rectangle from the origin that draws write and read, the whole target until set
+    void setRegion(Target target, int width, int height);
+
+    // An empty effect path copies. Pointwise effects only read the color they are given,
+    // others may sample tex around uv and start a new draw.
+    void addPass(const std::string &name, const std::string &effectPath, Target input, Target output,
+                 bool pointwise = true);
+
+    // Extra sampler for effects, bound to its own unit for every draw
+    void setTexture(const std::string &sampler, const Texture &texture);
+
+    // Sets the uniform in every compiled program that has it
+    template<typename T>
+    void setUniform(UniformName name, const T &value) {
+        for (auto &step : this->steps) {
+            if (step.shader == nullptr || step.shader->location(name) < 0) continue;
+            step.shader->use();
+            step.shader->setUniform(name, value);
+        }
+    }
+
+    void compile();
+
+    // Runs the compiled passes, compiles first if passes changed. Leaves the last output bound.
+    // With a timer, each draw or blit is timed as a pass named after its fused passes, e.g. "post dither+upscale".
+    void execute(GpuTimer *timer = nullptr);
+
+    // Drops passes and targets, programs are kept for the next compile
+    void clear();
+
+    // Results of the last compile
+    unsigned int draws = 0;    // Draws and blits per execute
+    unsigned int fused = 0;    // Passes folded into another pass's draw
+    unsigned int textures = 0; // Textures backing the transient targets
+
+private:
+    struct TargetInfo {
+        unsigned int framebuffer;
+        unsigned int texture;
+        int width;
+        int height;
+        bool transient;
+        int physical; // Index into physicals once compiled, transient targets only
+        int regionWidth;
+        int regionHeight;
+    };
+
+    struct Pass {
+        std::string name;
+        std::string effectPath;
+        Target input;
+        Target output;
+        bool pointwise;
+    };
+
+    // One draw or blit after fusion
+    struct Step {
+        std::vector<size_t> passes;
+        Target input;
+        Target output;
+        Target snap;    // Last target fused away, uv is snapped to its texels. BACKBUFFER for none.
+        Shader *shader; // Null for blits
+        GLint uvScale;  // Locations set per draw
+        GLint snapSize;
+        std::string label; // Timer pass name
+    };
+
+    struct Binding {
+        unsigned int framebuffer;
+        unsigned int texture;
+        int width;
+        int height;
+        int regionWidth;
+        int regionHeight;
+    };
+
+    struct Physical {
+        unsigned int framebuffer;
+        unsigned int texture;
+        int width;
+        int height;
+    };
+
+    Shader *program(const Step &step);
+
+    Binding binding(Target target) const;
+
+    void releasePhysicals();
+
+    std::vector<TargetInfo> targets;
+    std::vector<Pass> passes;
+    std::vector<Step> steps;
+    std::vector<Physical> physicals;
+    std::vector<std::pair<std::string, const Texture *>> samplers;
+    std::unordered_map<std::string, Shader *> programs; // By generated source
+
+    std::pair<int, int> backbuffer;
+    bool dirty = true;
+    unsigned int quadVao;
+    unsigned int quadVbo;
+};
+
+}
+
+#endif // GL_RENDER_GRAPH_H
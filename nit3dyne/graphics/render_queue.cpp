@@ -0,0 +1,134 @@
+#include "render_queue.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "nit3dyne/graphics/mesh_animated.h"
+
+namespace n3d {
+
+const int SHADER_BITS = 10;
+const int TEXTURE_BITS = 16;
+const int MATERIAL_BITS = 10;
+const int DEPTH_BITS = 24;
+
+static uint64_t bits(uint64_t value, int count) {
+    return value & ((uint64_t(1) << count) - 1);
+}
+
+void RenderQueue::begin(const mat4 &perspective, const mat4 &view) {
+    this->direct.begin(perspective, view);
+    this->culled = 0;
+    this->occluded = 0;
+}
+
+void RenderQueue::setOcclusion(OcclusionBuffer *buffer) {
+    this->occlusion = buffer;
+}
+
+uint32_t RenderQueue::sortId(std::unordered_map<const void *, uint32_t> &ids, const void *object) {
+    // Ids only group draws, wrapping past the key width within one flush costs batching, not correctness
+    return ids.emplace(object, ids.size()).first->second;
+}
+
+void RenderQueue::submit(Shader &shader, const Material &material, Texture *texture, Mesh &mesh,
+                         const mat4 &modelMat, int lod, RenderPass pass) {
+    this->direct.record(shader, material, texture, mesh, modelMat, lod, pass);
+}
+
+void RenderQueue::merge(const CommandList &list) {
+    this->culled += list.culled;
+
+    // Keys are built here, the id maps are shared by every list and only touched on this thread
+    for (const DrawItem &item : list.getItems()) {
+        if (this->occlusion != nullptr && !this->occlusion->test(item.worldMin, item.worldMax)) {
+            ++this->occluded;
+            continue;
+        }
+
+        // Log distribution keeps precision close to the camera
+        float depth = std::log2(1.f + item.distance) / std::log2(1.f + depthRange);
+        uint64_t depthBits = (uint64_t) (std::min(std::max(depth, 0.f), 1.f) * ((1 << DEPTH_BITS) - 1));
+
+        uint64_t shaderId = bits(sortId(this->shaderIds, item.shader), SHADER_BITS);
+        uint64_t textureId = bits(sortId(this->textureIds, item.texture), TEXTURE_BITS);
+        uint64_t materialId = bits(sortId(this->materialIds, item.material), MATERIAL_BITS);
+        uint64_t state = shaderId << (TEXTURE_BITS + MATERIAL_BITS) | textureId << MATERIAL_BITS | materialId;
+
+        uint64_t key = (uint64_t) item.pass << 60;
+        if (item.pass == PASS_TRANSPARENT) {
+            key |= bits(~depthBits, DEPTH_BITS) << 36 | state;
+        } else {
+            key |= state << DEPTH_BITS | depthBits;
+        }
+
+        this->keys.emplace_back(key, this->items.size());
+        this->items.push_back({&item, list.getJoints(item)});
+    }
+}
+
+void RenderQueue::flush() {
+    this->merge(this->direct);
+
+    // Index breaks ties, equal keys draw in submission order
+    std::sort(this->keys.begin(), this->keys.end());
+
+    this->draws = 0;
+    this->programBinds = 0;
+    this->textureBinds = 0;
+    this->materialBinds = 0;
+
+    Shader *shader = nullptr;
+    const Texture *texture = nullptr;
+    const Material *material = nullptr;
+
+    for (auto &key : this->keys) {
+        const Queued &queued = this->items[key.second];
+        const DrawItem &item = *queued.item;
+
+        if (item.shader != shader) {
+            shader = item.shader;
+            shader->use();
+            ++this->programBinds;
+
+            // Uniforms are program state, the new program has its own material
+            material = nullptr;
+        }
+
+        if (item.material != material) {
+            material = item.material;
+            shader->attachMaterial(*material);
+            ++this->materialBinds;
+        }
+
+        if (item.texture != nullptr && item.texture != texture) {
+            texture = item.texture;
+            GLState::bindTexture(GL_TEXTURE_2D, texture->handle);
+            ++this->textureBinds;
+        }
+
+        shader->setTransform(item.mvp, item.modelView, item.normalMat);
+
+        if (queued.joints != nullptr) {
+            static_cast<MeshAnimated *>(item.mesh)->drawPose(*shader, queued.joints, item.jointCount, item.lod);
+        } else {
+            item.mesh->draw(*shader, item.lod);
+        }
+        ++this->draws;
+    }
+
+    this->clear();
+}
+
+void RenderQueue::clear() {
+    this->direct.clear();
+    this->items.clear();
+    this->keys.clear();
+
+    // Ids only have to be dense within one flush, stale objects must not keep their slots
+    this->shaderIds.clear();
+    this->textureIds.clear();
+    this->materialIds.clear();
+}
+
+}
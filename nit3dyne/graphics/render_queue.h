@@ -0,0 +1,80 @@
+#ifndef GL_RENDER_QUEUE_H
+#define GL_RENDER_QUEUE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "nit3dyne/core/math.h"
+#include "nit3dyne/graphics/command_list.h"
+#include "nit3dyne/graphics/material.h"
+#include "nit3dyne/graphics/mesh.h"
+#include "nit3dyne/graphics/occlusion_buffer.h"
+#include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/texture.h"
+#include "nit3dyne/graphics/gl_state.h"
+
+namespace n3d {
+
+/*
+ * Deferred draws sorted by a packed 64 bit key:
+ *   opaque and overlay  pass:4 | shader:10 | texture:16 | material:10 | depth:24, front to back
+ *   transparent         pass:4 | depth:24 | shader:10 | texture:16 | material:10, back to front
+ * flush() walks the sorted list and only touches GL state that differs from the previous draw.
+ * Draws come from submit() on the GL thread or from CommandLists recorded elsewhere and merged.
+ */
+class RenderQueue {
+public:
+    // View distance mapped onto the depth bits, matches the camera's far plane
+    inline static float depthRange = 10000.f;
+
+    // Camera for the following submissions
+    void begin(const mat4 &perspective, const mat4 &view);
+
+    // Buffer to test submissions against, rasterized before submitting. Null disables occlusion culling.
+    void setOcclusion(OcclusionBuffer *buffer);
+
+    // Draws outside the camera's frustum or behind occluders are dropped here
+    void submit(Shader &shader, const Material &material, Texture *texture, Mesh &mesh, const mat4 &modelMat,
+                int lod = 0, RenderPass pass = PASS_OPAQUE);
+
+    // Takes a finished list's draws, GL thread. The list is read again by flush, keep it until then.
+    void merge(const CommandList &list);
+
+    // Sorts and draws everything submitted since begin, then empties the queue
+    void flush();
+
+    void clear();
+
+    // State changes issued by the last flush
+    unsigned int draws = 0;
+    unsigned int programBinds = 0;
+    unsigned int textureBinds = 0;
+    unsigned int materialBinds = 0;
+    unsigned int culled = 0;   // Submissions and merged recordings since begin outside the frustum
+    unsigned int occluded = 0; // Submissions since begin that were behind occluders
+
+private:
+    static uint32_t sortId(std::unordered_map<const void *, uint32_t> &ids, const void *object);
+
+    struct Queued {
+        const DrawItem *item;
+        const mat4 *joints;
+    };
+
+    CommandList direct; // Draws from submit
+    OcclusionBuffer *occlusion = nullptr;
+
+    std::vector<Queued> items;
+    std::vector<std::pair<uint64_t, uint32_t>> keys; // key, item index
+
+    // Small dense ids per state object so they fit the key, reassigned every flush
+    std::unordered_map<const void *, uint32_t> shaderIds;
+    std::unordered_map<const void *, uint32_t> textureIds;
+    std::unordered_map<const void *, uint32_t> materialIds;
+};
+
+}
+
+#endif // GL_RENDER_QUEUE_H
@@ -1,10 +1,15 @@
 #include "shader.h"
 
+#include "nit3dyne/graphics/frame_uniforms.h"
+#include "nit3dyne/core/profiler.h"
+
 namespace n3d {
 
 Shader::Shader(const char *vPath, const char *fPath) : Shader(vPath, fPath, nullptr) {}
 
 Shader::Shader(const char *vPath, const char *fPath, const char *gPath) {
+    N3D_PROFILE_SCOPE("Shader::Shader");
+
     std::string vSrc;
     std::string fSrc;
     std::string gSrc;
@@ -37,6 +42,25 @@ Shader::Shader(const char *vPath, const char *fPath, const char *gPath) {
         }
     } catch (std::ifstream::failure &e) { std::cout << "Shader read error" << std::endl; }
 
+    this->compile(vSrc, fSrc, gPath != nullptr ? &gSrc : nullptr);
+    if (!this->linked) {
+        std::cout << "VS: " << vPath << std::endl;
+        std::cout << "FS: " << fPath << std::endl;
+        if (gPath != nullptr) {
+            std::cout << "GS: " << gPath << std::endl;
+        }
+    }
+}
+
+Shader *Shader::fromSource(const std::string &vSrc, const std::string &fSrc) {
+    N3D_PROFILE_SCOPE("Shader::fromSource");
+
+    auto *shader = new Shader();
+    shader->compile(preprocessShader(vSrc), preprocessShader(fSrc), nullptr);
+    return shader;
+}
+
+void Shader::compile(const std::string &vSrc, const std::string &fSrc, const std::string *gSrc) {
     unsigned int vId, fId, gId;
     int success;
     char infoLog[512];
@@ -61,9 +85,9 @@ Shader::Shader(const char *vPath, const char *fPath, const char *gPath) {
         std::cout << "Error: Failed to compile fragment shader\n" << infoLog << std::endl;
     }
 
-    if (gPath != nullptr) {
+    if (gSrc != nullptr) {
         gId = glCreateShader(GL_GEOMETRY_SHADER);
-        const char *gSrcC = gSrc.c_str();
+        const char *gSrcC = gSrc->c_str();
         glShaderSource(gId, 1, &gSrcC, NULL);
         glCompileShader(gId);
         glGetShaderiv(gId, GL_COMPILE_STATUS, &success);
@@ -76,7 +100,7 @@ Shader::Shader(const char *vPath, const char *fPath, const char *gPath) {
     this->handle = glCreateProgram();
     glAttachShader(this->handle, vId);
     glAttachShader(this->handle, fId);
-    if (gPath != nullptr)
+    if (gSrc != nullptr)
         glAttachShader(this->handle, gId);
     glLinkProgram(this->handle);
 
@@ -84,98 +108,221 @@ Shader::Shader(const char *vPath, const char *fPath, const char *gPath) {
     if (!success) {
         glGetProgramInfoLog(this->handle, 512, NULL, infoLog);
         std::cout << "Error: Failed to link shader program\n" << infoLog << std::endl;
-        std::cout << "VS: " << vPath << std::endl;
-        std::cout << "FS: " << fPath << std::endl;
-        if (gPath != nullptr) {
-            std::cout << "GS: " << gPath << std::endl;
-        }
     }
+    this->linked = success != 0;
 
     glDeleteShader(vId);
     glDeleteShader(fId);
-    if (gPath != nullptr) {
+    if (gSrc != nullptr) {
         glDeleteShader(gId);
     }
+
+    this->introspect();
 }
 
 void Shader::use() const {
-    glUseProgram(this->handle);
+    GLState::useProgram(this->handle);
+}
+
+void Shader::addUniform(const std::string &name, GLint location) {
+    entt::id_type id = UniformName(name).id;
+#ifndef NDEBUG
+    // A collision would hand one uniform's location to the other's name
+    auto named = this->uniformNames.emplace(id, name).first;
+    assert(named->second == name && "uniform names hash the same");
+#endif
+    this->uniforms[id] = location;
+}
+
+void Shader::introspect() {
+    // Shared blocks live at fixed binding points, GLSL 330 cannot declare the binding itself
+    GLuint frameBlock = glGetUniformBlockIndex(this->handle, "FrameData");
+    if (frameBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->handle, frameBlock, BINDING_FRAME);
+
+    GLuint lightBlock = glGetUniformBlockIndex(this->handle, "LightData");
+    if (lightBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->handle, lightBlock, BINDING_LIGHTS);
+
+    GLuint jointBlock = glGetUniformBlockIndex(this->handle, "JointPalette");
+    if (jointBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->handle, jointBlock, BINDING_JOINTS);
+
+    // Same for the clustered light buffers, sampler units are program state
+    const char *lightSamplers[3] = {"lightBuffer", "lightClusters", "lightIndices"};
+    const GLint lightUnits[3] = {UNIT_LIGHTS, UNIT_LIGHT_CLUSTERS, UNIT_LIGHT_INDICES};
+    for (int i = 0; i < 3; ++i) {
+        GLint sampler = glGetUniformLocation(this->handle, lightSamplers[i]);
+        if (sampler < 0) continue;
+        GLState::useProgram(this->handle);
+        glUniform1i(sampler, lightUnits[i]);
+    }
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(this->handle, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(this->handle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> nameBuffer(maxLength + 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type;
+        glGetActiveUniform(this->handle, i, nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+
+        std::string name(nameBuffer.data(), length);
+        GLint location = glGetUniformLocation(this->handle, name.c_str());
+        if (location < 0) continue; // Block members have no location
+        this->addUniform(name, location);
+
+        // Arrays are reported as "name[0]", make the bare name and every element resolvable too
+        size_t bracket = name.rfind("[0]");
+        if (bracket == std::string::npos || bracket + 3 != name.size()) continue;
+
+        std::string base = name.substr(0, bracket);
+        this->addUniform(base, location);
+        for (GLint element = 1; element < size; ++element) {
+            std::string elementName = base + "[" + std::to_string(element) + "]";
+            this->addUniform(elementName, glGetUniformLocation(this->handle, elementName.c_str()));
+        }
+    }
+
+    this->transformUniforms = {
+            UniformHandle<mat4>(*this, "mvp"),
+            UniformHandle<mat4>(*this, "modelView"),
+            UniformHandle<mat3>(*this, "normalMat")
+    };
+    this->materialUniforms = {
+            UniformHandle<vec3>(*this, "material.ambient"),
+            UniformHandle<vec3>(*this, "material.diffuse"),
+            UniformHandle<vec3>(*this, "material.specular"),
+            UniformHandle<float>(*this, "material.shininess")
+    };
+}
+
+GLint Shader::location(UniformName name) const {
+    auto found = this->uniforms.find(name.id);
+    return found == this->uniforms.end() ? -1 : found->second;
+}
+
+void Shader::setUniform(UniformName name, bool value) const {
+    upload(this->location(name), value);
+}
+
+void Shader::setUniform(UniformName name, int value) const {
+    upload(this->location(name), value);
+}
+
+void Shader::setUniform(UniformName name, unsigned int value) const {
+    upload(this->location(name), value);
+}
+
+void Shader::setUniform(UniformName name, float value) const {
+    upload(this->location(name), value);
+}
+
+void Shader::setUniform(UniformName name, double value) const {
+    upload(this->location(name), value);
+}
+
+void Shader::setUniform(UniformName name, const mat3 &mat) const {
+    upload(this->location(name), mat);
+}
+
+void Shader::setUniform(UniformName name, const mat4 &mat) const {
+    upload(this->location(name), mat);
+}
+
+void Shader::setUniform(UniformName name, const vec2 &vec) const {
+    upload(this->location(name), vec);
+}
+
+void Shader::setUniform(UniformName name, const vec3 &vec) const {
+    upload(this->location(name), vec);
+}
+
+void Shader::setUniform(UniformName name, const vec4 &vec) const {
+    upload(this->location(name), vec);
 }
 
-void Shader::setUniform(const std::string &name, const bool value) const {
-    glUniform1i(glGetUniformLocation(this->handle, name.c_str()), (int) value);
+void Shader::setUniform(UniformName name, const std::vector<mat4> &mats) const {
+    upload(this->location(name), mats);
 }
 
-void Shader::setUniform(const std::string &name, const float value) const {
-    glUniform1f(glGetUniformLocation(this->handle, name.c_str()), value);
+void Shader::upload(GLint location, bool value) {
+    glUniform1i(location, (int) value);
 }
 
-void Shader::setUniform(const std::string &name, const int value) const {
-    glUniform1i(glGetUniformLocation(this->handle, name.c_str()), value);
+void Shader::upload(GLint location, float value) {
+    glUniform1f(location, value);
 }
 
-void Shader::setUniform(const std::string &name, const mat3 &mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(this->handle, name.c_str()),
+void Shader::upload(GLint location, int value) {
+    glUniform1i(location, value);
+}
+
+void Shader::upload(GLint location, unsigned int value) {
+    glUniform1ui(location, value);
+}
+
+void Shader::upload(GLint location, double value) {
+    glUniform1f(location, (float) value);
+}
+
+void Shader::upload(GLint location, const mat3 &mat) {
+    glUniformMatrix3fv(location,
                        1,        // Send one
                        GL_FALSE, // Don't transpose (swap rows/cols)
                        value_ptr(mat));
 }
 
-void Shader::setUniform(const std::string &name, const mat4 &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(this->handle, name.c_str()),
+void Shader::upload(GLint location, const mat4 &mat) {
+    glUniformMatrix4fv(location,
                        1,        // Send one
                        GL_FALSE, // Don't transpose (swap rows/cols)
                        value_ptr(mat));
 }
 
-void Shader::setUniform(const std::string &name, const vec3 &vec) const {
-    glUniform3fv(glGetUniformLocation(this->handle, name.c_str()),
+void Shader::upload(GLint location, const vec2 &vec) {
+    glUniform2fv(location,
+                 1, // Send one
+                 value_ptr(vec));
+}
+
+void Shader::upload(GLint location, const vec3 &vec) {
+    glUniform3fv(location,
                  1, // Send one
                  value_ptr(vec));
 }
 
-void Shader::setUniform(const std::string &name, const vec4 &vec) const {
-    glUniform4fv(glGetUniformLocation(this->handle, name.c_str()),
+void Shader::upload(GLint location, const vec4 &vec) {
+    glUniform4fv(location,
                  1, // Send one
                  value_ptr(vec));
 }
 
-void Shader::setUniform(const std::string &name, const std::vector<mat4> &mats) const {
-    glUniformMatrix4fv(glGetUniformLocation(this->handle, name.c_str()),
+void Shader::upload(GLint location, const std::vector<mat4> &mats) {
+    if (mats.empty()) return;
+    glUniformMatrix4fv(location,
                        mats.size(), // Send all
                        GL_FALSE,
                        value_ptr(mats.front()));
 }
 
 Shader::~Shader() {
-    glDeleteProgram(this->handle);
+    GLState::deleteProgram(this->handle);
 }
 
 void Shader::attachMaterial(const Material &material) const {
-    this->setUniform("material.ambient", material.ambient);
-    this->setUniform("material.diffuse", material.diffuse);
-    this->setUniform("material.specular", material.specular);
-    this->setUniform("material.shininess", material.shininess);
-}
-
-void Shader::setDirectionalLight(const DirectionalLight &dLight) const {
-    this->setUniform("dLight.direction", dLight.direction);
-
-    this->setUniform("dLight.ambient", dLight.ambient);
-    this->setUniform("dLight.diffuse", dLight.diffuse);
-    this->setUniform("dLight.specular", dLight.specular);
+    this->materialUniforms.ambient.set(material.ambient);
+    this->materialUniforms.diffuse.set(material.diffuse);
+    this->materialUniforms.specular.set(material.specular);
+    this->materialUniforms.shininess.set(material.shininess);
 }
 
-void Shader::setSpotLight(const SpotLight &sLight) const {
-    this->setUniform("sLight.direction", sLight.direction);
-    this->setUniform("sLight.position", sLight.position);
-    this->setUniform("sLight.cutOff", sLight.cutOff);
+void Shader::setTransform(const mat4 &mvp, const mat4 &modelView, const mat3 &normalMat) const {
+    this->transformUniforms.mvp.set(mvp);
+    this->transformUniforms.modelView.set(modelView);
+    this->transformUniforms.normalMat.set(normalMat);
 }
 
-void Shader::setUniform(const std::string &name, const vec2 &vec) const {
-    glUniform2fv(glGetUniformLocation(this->handle, name.c_str()),
-                 1, // Send one
-                 value_ptr(vec));
 }
-
-}
\ No newline at end of file
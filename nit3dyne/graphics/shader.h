@@ -4,19 +4,68 @@
 #include <glad/glad.h>
 
 
+#include <cassert>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <entt/core/hashed_string.hpp>
+
 #include "nit3dyne/core/math.h"
 #include "nit3dyne/graphics/lighting.h"
 #include "nit3dyne/graphics/material.h"
 #include "nit3dyne/graphics/shader_preprocess.h"
+#include "nit3dyne/graphics/gl_state.h"
 
 namespace n3d {
 
+class Shader;
+
+// Uniform name as its hash, computed at compile time for literals and at run time for strings
+struct UniformName {
+    template<size_t N>
+    constexpr UniformName(const char (&name)[N]) : id(entt::hashed_string(name).value()) {}
+
+    constexpr UniformName(entt::hashed_string name) : id(name.value()) {}
+
+    UniformName(const std::string &name) : id(entt::hashed_string::value(name.c_str(), name.size())) {}
+
+    entt::id_type id;
+};
+
+// Uniform location resolved once, set() skips the name lookup. The program still has to be in use.
+template<typename T>
+class UniformHandle {
+public:
+    UniformHandle() = default;
+
+    UniformHandle(const Shader &shader, UniformName name);
+
+    void set(const T &value) const;
+
+    bool valid() const { return this->location >= 0; }
+
+private:
+    GLint location = -1;
+};
+
+// Handles for the uniforms every lit shader shares, invalid when a program does not declare them
+struct TransformUniforms {
+    UniformHandle<mat4> mvp;
+    UniformHandle<mat4> modelView;
+    UniformHandle<mat3> normalMat;
+};
+
+struct MaterialUniforms {
+    UniformHandle<vec3> ambient;
+    UniformHandle<vec3> diffuse;
+    UniformHandle<vec3> specular;
+    UniformHandle<float> shininess;
+};
+
 class Shader {
 
 public:
@@ -26,35 +75,96 @@ public:
 
     Shader(const char *vPath, const char *fPath, const char *gPath);
 
+    // Generated sources, includes are resolved like for files
+    static Shader *fromSource(const std::string &vSrc, const std::string &fSrc);
+
     ~Shader();
 
     void use() const;
 
     void attachMaterial(const Material &material) const;
 
-    void setDirectionalLight(const DirectionalLight &dLight) const;
+    void setTransform(const mat4 &mvp, const mat4 &modelView, const mat3 &normalMat) const;
+
+    // Location from the cache built at link, -1 if the program has no such active uniform
+    GLint location(UniformName name) const;
+
+    // Name is hashed, not looked up by the driver. Prefer a UniformHandle on hot paths.
+    void setUniform(UniformName name, bool value) const;
 
-    void setSpotLight(const SpotLight &sLight) const;
+    void setUniform(UniformName name, int value) const;
 
-    void setUniform(const std::string &name, const bool value) const;
+    void setUniform(UniformName name, unsigned int value) const;
 
-    void setUniform(const std::string &name, const int value) const;
+    void setUniform(UniformName name, float value) const;
 
-    void setUniform(const std::string &name, const float value) const;
+    void setUniform(UniformName name, double value) const;
 
-    void setUniform(const std::string &name, const mat3 &mat) const;
+    void setUniform(UniformName name, const mat3 &mat) const;
 
-    void setUniform(const std::string &name, const mat4 &mat) const;
+    void setUniform(UniformName name, const mat4 &mat) const;
 
-    void setUniform(const std::string &name, const vec2 &vec) const;
+    void setUniform(UniformName name, const vec2 &vec) const;
 
-    void setUniform(const std::string &name, const vec3 &vec) const;
+    void setUniform(UniformName name, const vec3 &vec) const;
 
-    void setUniform(const std::string &name, const vec4 &vec) const;
+    void setUniform(UniformName name, const vec4 &vec) const;
 
-    void setUniform(const std::string &name, const std::vector<mat4> &mats) const;
+    void setUniform(UniformName name, const std::vector<mat4> &mats) const;
+
+    // Doubles are sent as floats
+    static void upload(GLint location, bool value);
+
+    static void upload(GLint location, int value);
+
+    static void upload(GLint location, unsigned int value);
+
+    static void upload(GLint location, float value);
+
+    static void upload(GLint location, double value);
+
+    static void upload(GLint location, const mat3 &mat);
+
+    static void upload(GLint location, const mat4 &mat);
+
+    static void upload(GLint location, const vec2 &vec);
+
+    static void upload(GLint location, const vec3 &vec);
+
+    static void upload(GLint location, const vec4 &vec);
+
+    static void upload(GLint location, const std::vector<mat4> &mats);
+
+    TransformUniforms transformUniforms;
+    MaterialUniforms materialUniforms;
+
+private:
+    Shader() = default;
+
+    // Compiles and links, then introspects. No geometry stage when gSrc is null.
+    void compile(const std::string &vSrc, const std::string &fSrc, const std::string *gSrc);
+
+    // Fills the cache from the program's active uniforms
+    void introspect();
+
+    void addUniform(const std::string &name, GLint location);
+
+    std::unordered_map<entt::id_type, GLint> uniforms;
+#ifndef NDEBUG
+    std::unordered_map<entt::id_type, std::string> uniformNames;
+#endif
+    bool linked = false;
 };
 
+template<typename T>
+UniformHandle<T>::UniformHandle(const Shader &shader, UniformName name) :
+        location(shader.location(name)) {}
+
+template<typename T>
+void UniformHandle<T>::set(const T &value) const {
+    Shader::upload(this->location, value);
+}
+
 }
 
 #endif // GL_SHADER_H
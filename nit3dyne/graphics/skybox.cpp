@@ -26,7 +26,7 @@ const std::string path = "res/cubemap/";
 
 Skybox::Skybox(const std::string &resourceName) {
     glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
+    GLState::bindVertexArray(this->VAO);
 
     std::vector<std::string> faceFilePaths(6);
     for (size_t i = 0; i < 6; ++i)
@@ -34,7 +34,7 @@ Skybox::Skybox(const std::string &resourceName) {
 
     unsigned int VBO;
     glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
 
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
@@ -43,14 +43,13 @@ Skybox::Skybox(const std::string &resourceName) {
     assert(faceFilePaths.size() == 6);
 
     glGenTextures(1, &this->handle);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->handle);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, this->handle);
 
     int w, h, nChannels;
     unsigned char *data;
 
-    stbi_set_flip_vertically_on_load(false);
     for (size_t i = 0; i < faceFilePaths.size(); ++i) {
-        data = stbi_load(faceFilePaths[i].c_str(), &w, &h, &nChannels, 0);
+        data = loadImage(faceFilePaths[i], &w, &h, &nChannels);
 
         if (data) {
             //assert(nChannels == 3);
@@ -63,7 +62,6 @@ Skybox::Skybox(const std::string &resourceName) {
         }
         stbi_image_free(data);
     }
-    stbi_set_flip_vertically_on_load(true);
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -72,21 +70,18 @@ Skybox::Skybox(const std::string &resourceName) {
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 }
 
-void Skybox::draw(Shader &shader, mat4 &&view, mat4 &proj) {
-    glDepthFunc(GL_LEQUAL);
+void Skybox::draw(Shader &shader) {
+    GLState::depthFunc(GL_LEQUAL);
     shader.use();
 
-    shader.setUniform("view", view);
-    shader.setUniform("proj", proj);
-
-    glBindVertexArray(this->VAO);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, this->handle);
+    GLState::bindVertexArray(this->VAO);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, this->handle);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glDepthFunc(GL_LESS);
+    GLState::depthFunc(GL_LESS);
 }
 
 Skybox::~Skybox() {
-    glDeleteTextures(1, &this->handle);
+    GLState::deleteTextures(1, &this->handle);
 }
 
 }
\ No newline at end of file
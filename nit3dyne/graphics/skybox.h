@@ -13,6 +13,8 @@
 #include <glad/glad.h>
 
 #include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/texture.h"
+#include "nit3dyne/graphics/gl_state.h"
 
 namespace n3d {
 
@@ -22,7 +24,8 @@ public:
 
     ~Skybox();
 
-    void draw(Shader &shader, mat4 &&view, mat4 &proj);
+    // Camera comes from the frame uniform block
+    void draw(Shader &shader);
 
 private:
     unsigned int handle;
@@ -0,0 +1,143 @@
+#include "stream_buffer.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace n3d {
+
+StreamBuffer::StreamBuffer(GLenum target, size_t size) : target(target), size(size) {
+    glGenBuffers(1, &this->handle);
+    GLState::bindBuffer(target, this->handle);
+    glBufferData(target, (GLsizeiptr) size, nullptr, GL_STREAM_DRAW);
+
+    if (target == GL_UNIFORM_BUFFER) {
+        GLint alignment = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        this->minAlignment = (size_t) std::max(alignment, 1);
+    }
+
+    buffers.push_back(this);
+}
+
+StreamBuffer::~StreamBuffer() {
+    this->commit();
+    for (Frame &frame : this->inFlight)
+        glDeleteSync(frame.fence);
+    GLState::deleteBuffers(1, &this->handle);
+
+    buffers.erase(std::remove(buffers.begin(), buffers.end(), this), buffers.end());
+}
+
+void *StreamBuffer::map(size_t bytes, size_t alignment, GLintptr &offset) {
+    this->commit();
+    if (bytes == 0) return nullptr;
+
+    alignment = std::max(alignment, this->minAlignment);
+    if (bytes > this->size) this->grow(bytes);
+
+    size_t begin = (this->head + alignment - 1) / alignment * alignment;
+    if (begin + bytes > this->size) begin = 0;
+
+    // Wrapped into this frame's own data, the ring is too small for a frame. Ending exactly at the frame's start
+    // counts too: the frame would fill the ring and its range would read as empty.
+    bool own = this->frameUsed && overlaps(begin, begin + bytes, this->frameStart, this->head);
+    if (own || begin + bytes == this->frameStart) {
+        this->grow(bytes);
+        begin = 0;
+    }
+
+    // Frames retire in order, waiting on the newest overlapping one covers the older ones
+    int retire = -1;
+    for (size_t i = 0; i < this->inFlight.size(); ++i) {
+        const Frame &frame = this->inFlight[i];
+        if (overlaps(begin, begin + bytes, frame.start, frame.end)) retire = (int) i;
+    }
+    if (retire >= 0) {
+        wait(this->inFlight[retire].fence);
+        for (int i = 0; i <= retire; ++i) {
+            if (i < retire) glDeleteSync(this->inFlight.front().fence);
+            this->inFlight.pop_front();
+        }
+    }
+
+    GLState::bindBuffer(this->target, this->handle);
+    void *data = glMapBufferRange(
+            this->target,
+            (GLintptr) begin,
+            (GLsizeiptr) bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+    );
+    if (data == nullptr) {
+        std::cout << "Stream buffer error: failed to map " << bytes << " bytes" << std::endl;
+        return nullptr;
+    }
+
+    this->mapped = true;
+    this->frameUsed = true;
+    this->head = begin + bytes;
+    offset = (GLintptr) begin;
+    return data;
+}
+
+void StreamBuffer::commit() {
+    if (!this->mapped) return;
+
+    GLState::bindBuffer(this->target, this->handle);
+    if (glUnmapBuffer(this->target) == GL_FALSE)
+        std::cout << "Stream buffer error: contents lost while mapped" << std::endl;
+    this->mapped = false;
+}
+
+void StreamBuffer::endFrames() {
+    for (StreamBuffer *buffer : buffers)
+        buffer->endFrame();
+}
+
+void StreamBuffer::endFrame() {
+    this->commit();
+    if (!this->frameUsed) return;
+
+    this->inFlight.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), this->frameStart, this->head});
+    this->frameStart = this->head;
+    this->frameUsed = false;
+}
+
+void StreamBuffer::grow(size_t bytes) {
+    this->commit();
+
+    // Orphaning hands the old storage to the draws still using it, its fences no longer matter
+    for (Frame &frame : this->inFlight)
+        glDeleteSync(frame.fence);
+    this->inFlight.clear();
+
+    this->size = std::max(this->size * 2, bytes * 2);
+    GLState::bindBuffer(this->target, this->handle);
+    glBufferData(this->target, (GLsizeiptr) this->size, nullptr, GL_STREAM_DRAW);
+
+    this->head = 0;
+    this->frameStart = 0;
+    this->frameUsed = false;
+
+    std::cout << "Stream buffer: grew to " << this->size << " bytes, one frame did not fit" << std::endl;
+}
+
+bool StreamBuffer::overlaps(size_t begin, size_t end, size_t start, size_t stop) {
+    if (start == stop) return false;
+    if (start < stop) return begin < stop && start < end;
+
+    // Region wraps, [start, size) and [0, stop)
+    return end > start || begin < stop;
+}
+
+void StreamBuffer::wait(GLsync fence) {
+    GLenum result;
+    do {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while (result == GL_TIMEOUT_EXPIRED);
+
+    if (result == GL_WAIT_FAILED)
+        std::cout << "Stream buffer error: fence wait failed" << std::endl;
+    glDeleteSync(fence);
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef GL_STREAM_BUFFER_H
+#define GL_STREAM_BUFFER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "nit3dyne/graphics/gl_state.h"
+
+namespace n3d {
+
+// Writable window into a StreamBuffer, offset is in bytes from the start of the buffer
+template<typename T>
+struct StreamSpan {
+    T *data = nullptr;
+    size_t count = 0;
+    GLintptr offset = 0;
+
+    explicit operator bool() const { return this->data != nullptr; }
+
+    T &operator[](size_t i) { return this->data[i]; }
+
+    T *begin() { return this->data; }
+
+    T *end() { return this->data + this->count; }
+
+    GLsizeiptr bytes() const { return (GLsizeiptr) (this->count * sizeof(T)); }
+};
+
+/*
+ * Ring of per-frame GPU data. Allocations are mapped unsynchronized, the driver never waits on
+ * the GPU; instead each frame's range is fenced at endFrames() and only waited on once the ring
+ * wraps around to it.
+ * A span is writable until the next allocate or commit, which unmaps it; commit before drawing.
+ * If one frame outgrows the ring, the storage is orphaned and doubled, so size it for a frame.
+ */
+class StreamBuffer {
+public:
+    // target is the binding used to map, not GL_ELEMENT_ARRAY_BUFFER which belongs to the bound VAO
+    StreamBuffer(GLenum target, size_t size);
+
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    // Uniform buffers also align to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    template<typename T>
+    StreamSpan<T> allocate(size_t count, size_t alignment = alignof(T)) {
+        StreamSpan<T> span;
+        span.data = (T *) this->map(count * sizeof(T), alignment, span.offset);
+        span.count = span.data != nullptr ? count : 0;
+        return span;
+    }
+
+    // Unmaps the open span, if any
+    void commit();
+
+    // Fences this frame's allocations, called for every stream buffer by Display::flip
+    static void endFrames();
+
+    GLuint getHandle() const { return this->handle; }
+
+    size_t getSize() const { return this->size; }
+
+private:
+    struct Frame {
+        GLsync fence;
+        size_t start;
+        size_t end; // Less than start if the frame wrapped
+    };
+
+    void *map(size_t bytes, size_t alignment, GLintptr &offset);
+
+    void endFrame();
+
+    void grow(size_t bytes);
+
+    static bool overlaps(size_t begin, size_t end, size_t start, size_t stop);
+
+    static void wait(GLsync fence);
+
+    inline static std::vector<StreamBuffer *> buffers;
+
+    GLenum target;
+    GLuint handle = 0;
+    size_t size;
+    size_t minAlignment = 1;
+
+    size_t head = 0;       // Next free byte
+    size_t frameStart = 0; // Where this frame's allocations began
+    bool frameUsed = false; // Allocated since frameStart. A frame never fills the ring, so its range is never empty.
+    bool mapped = false;
+    std::deque<Frame> inFlight;
+};
+
+}
+
+#endif // GL_STREAM_BUFFER_H
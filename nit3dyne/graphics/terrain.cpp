@@ -1,5 +1,9 @@
 #include "terrain.h"
 
+#include <algorithm>
+
+#include "nit3dyne/core/profiler.h"
+
 namespace n3d {
 
 Terrain::Terrain(std::string resourceName) {
@@ -9,11 +13,20 @@ Terrain::Terrain(std::string resourceName) {
     this->model = translate(this->model, vec3(-(100 * 50.f), -365.f, -(100 * 50.f)));
 }
 
+Terrain::~Terrain() {
+    GeometryPool::free(this->geometry);
+}
+
 void Terrain::updateChunks(int x, int y) {
 
 }
 
 void Terrain::draw(Shader &shader, const mat4 &perspective, const mat4 &view) {
+    vec3 center = (this->boundsMin + this->boundsMax) * .5f;
+    float radius = glm::length(this->boundsMax - center);
+    if (!Frustum(perspective * view).containsBounds(this->boundsMin, this->boundsMax, center, radius, this->model))
+        return;
+
     shader.use();
     shader.attachMaterial(Materials::basic);
 
@@ -21,25 +34,28 @@ void Terrain::draw(Shader &shader, const mat4 &perspective, const mat4 &view) {
     mat4 modelView = view * this->model;
     mat3 normalMat = inverse(transpose(mat3(modelView)));
 
-    shader.setUniform("mvp", mvp);
-    shader.setUniform("modelView", modelView);
-    shader.setUniform("normalMat", normalMat);
+    shader.setTransform(mvp, modelView, normalMat);
 
-    glBindVertexArray(this->VAO);
-    glDrawElements(
+    GeometryPool::bind(this->geometry);
+    glDrawElementsBaseVertex(
             GL_TRIANGLES,
-            this->indices.size(),
+            this->geometry.indexCount,
             GL_UNSIGNED_INT,
-            0
+            (char *) nullptr + this->geometry.firstIndex * sizeof(uint32_t),
+            this->geometry.baseVertex
     );
-
-    glBindVertexArray(0);
 }
 
 std::vector<TerrainVertex> *Terrain::readHeights(std::string heightsFn, std::string normalsFn) {
+    N3D_PROFILE_SCOPE("Terrain::readHeights");
+
     int c, w, h;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char *heightsData = stbi_load(heightsFn.c_str(), &w, &h, &c, 0); // FIXME: leaks
+    unsigned char *heightsData = loadImage(heightsFn, &w, &h, &c); // FIXME: leaks
+
+    // Bottom row first
+    size_t stride = (size_t) w * c;
+    for (int y = 0; y < h / 2; ++y)
+        std::swap_ranges(heightsData + stride * y, heightsData + stride * (y + 1), heightsData + stride * (h - 1 - y));
 
     auto *out = new std::vector<TerrainVertex>; // FIXME: leaks
 
@@ -92,66 +108,21 @@ std::vector<TerrainVertex> *Terrain::readHeights(std::string heightsFn, std::str
         this->indices.push_back(i + w + 1);
     }
 
+    if (!out->empty()) {
+        this->boundsMin = this->boundsMax = out->front().vertex;
+        for (const TerrainVertex &vertex : *out) {
+            this->boundsMin = glm::min(this->boundsMin, vertex.vertex);
+            this->boundsMax = glm::max(this->boundsMax, vertex.vertex);
+        }
+    }
+
     std::cout << this->indices.size() << std::endl;
     std::cout << out->size() << std::endl;
 
-    glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
-
-    unsigned int VBO;
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    glBufferData(
-            GL_ARRAY_BUFFER,
-            sizeof(TerrainVertex) * out->size(),
-            &out->front(),
-            GL_STATIC_DRAW
-    );
-
-    glEnableVertexAttribArray(0); // POS
-    glVertexAttribPointer(
-            0, 3,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(TerrainVertex),
-            (void *) 0
-    );
-
-    glEnableVertexAttribArray(1); // NORMAL
-    glVertexAttribPointer(
-            1, 3,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(TerrainVertex),
-            (void *) offsetof(TerrainVertex, normal)
-    );
-
-    glEnableVertexAttribArray(2);
-    glVertexAttribIPointer( // TEXT
-            2, 1,
-            GL_INT,
-            sizeof(TerrainVertex),
-            (void *) offsetof(TerrainVertex, texture)
-    );
-
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer( // UV
-            3, 2,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(TerrainVertex),
-            (void *) offsetof(TerrainVertex, uv)
-    );
-
-    unsigned int EBO;
-    glGenBuffers(1, &EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(int), &this->indices[0], GL_STATIC_DRAW);
+    this->geometry = GeometryPool::allocate(LAYOUT_TERRAIN, out->size(), this->indices.size());
+    GeometryPool::upload(this->geometry, &out->front(), &this->indices[0]);
 
     return out;
-
-    glBindVertexArray(0);
 }
 
 }
@@ -9,7 +9,10 @@
 #include <stb_image.h>
 
 #include "nit3dyne/core/math.h"
+#include "nit3dyne/camera/frustum.h"
 #include "nit3dyne/graphics/shader.h"
+#include "nit3dyne/graphics/texture.h"
+#include "nit3dyne/graphics/geometry_pool.h"
 
 namespace n3d {
 
@@ -46,14 +49,16 @@ class Terrain {
 public:
     Terrain(std::string resourceName);
 
+    ~Terrain();
+
     //std::vector<TerrainChunk> chunks;
 
     // unload out of range chunks, load in-range chunks
     void updateChunks(int x, int y);
 
     int width = 7;  // 49 chunks centered on location, total size ~2.2M, 800K verts, 192 meter draw dist
-    unsigned int VAO; // TODO: remove
-    std::vector<int> indices;
+    GeometryRange geometry;
+    std::vector<uint32_t> indices;
     // FIXME: draw dist exceeds the far clip pane, halve the size of chunks
 
     // draw all chunks
@@ -61,6 +66,10 @@ public:
 
     mat4 model = mat4(1.f);
 
+    // Local bounds of the height field
+    vec3 boundsMin = vec3(0.f);
+    vec3 boundsMax = vec3(0.f);
+
     std::vector<TerrainVertex> *readHeights(std::string heightsFn, std::string normalsFn);
 };
 
@@ -5,37 +5,47 @@ namespace n3d {
 const std::string ext = ".png";
 const std::string path = "res/texture/";
 
-Texture::Texture(const std::string &resourceName) {
-    stbi_set_flip_vertically_on_load(false);
-    unsigned char *data =
-            stbi_load((path + resourceName + ext).c_str(), &this->w, &this->h, &this->channels, 0);
+unsigned char *loadImage(const std::string &fileName, int *w, int *h, int *channels) {
+    return stbi_load(fileName.c_str(), w, h, channels, 0);
+}
+
+TextureSource::~TextureSource() {
+    stbi_image_free(this->data);
+}
+
+std::unique_ptr<Texture::Source> Texture::decode(const std::string &resourceName) {
+    auto source = std::make_unique<Source>();
+    source->data = loadImage(path + resourceName + ext, &source->w, &source->h, &source->channels);
 #ifndef NDEBUG
-    if (!data) {
+    if (!source->data) {
         std::cout << "Failed to load texture: " << resourceName << std::endl;
     }
 #endif
 
+    return source;
+}
+
+Texture::Texture(const std::string &resourceName) : Texture(resourceName, *decode(resourceName)) {}
+
+Texture::Texture(const std::string &resourceName, Source &source) :
+        channels(source.channels), w(source.w), h(source.h) {
     int mode = GL_RGB;
     if (this->channels == 4)
         mode = GL_RGBA;
 
     glGenTextures(1, &this->handle);
-    glBindTexture(GL_TEXTURE_2D, this->handle);
+    GLState::bindTexture(GL_TEXTURE_2D, this->handle);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, mode, this->w, this->h, 0, mode, GL_UNSIGNED_BYTE, data);
-
-    stbi_image_free(data);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, mode, this->w, this->h, 0, mode, GL_UNSIGNED_BYTE, source.data);
 }
 
 Texture::~Texture() {
-    glDeleteTextures(1, &this->handle);
+    GLState::deleteTextures(1, &this->handle);
 }
 
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 #define GL_TEXTURE_H
 
 #include <glad/glad.h>
+#include <memory>
 #include <string>
 #ifndef NDEBUG
 #include <iostream>
@@ -9,15 +10,35 @@
 
 #include <stb_image.h>
 #include "nit3dyne/graphics/material.h"
+#include "nit3dyne/graphics/gl_state.h"
 
 namespace n3d {
 
+// Rows top down as stored. stb's vertical flip flag is global and never set, so loads run in parallel.
+unsigned char *loadImage(const std::string &fileName, int *w, int *h, int *channels);
+
+// Decoded pixels, produced by Texture::decode on any thread
+struct TextureSource {
+    unsigned char *data = nullptr;
+    int channels = 0;
+    int w = 0;
+    int h = 0;
+
+    ~TextureSource();
+};
+
 class Texture {
 public:
+    using Source = TextureSource;
+
     explicit Texture(const std::string &resourceName);
 
+    Texture(const std::string &resourceName, Source &source);
+
     ~Texture();
 
+    static std::unique_ptr<Source> decode(const std::string &resourceName);
+
     unsigned int handle;
     int channels;
     int w;
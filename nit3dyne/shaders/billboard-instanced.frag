@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 texCoord;
+in vec4 color;
+out vec4 fragColor;
+
+uniform sampler2D tex;
+uniform float alphaCutoff;
+
+void main() {
+    fragColor = texture(tex, texCoord) * color;
+    if (fragColor.a < alphaCutoff)
+        discard;
+}
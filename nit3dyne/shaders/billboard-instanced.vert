@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec2 inVertex;
+layout (location = 1) in vec3 inPosition; // Per instance
+layout (location = 2) in vec2 inSize;
+layout (location = 3) in vec4 inUvRect;
+layout (location = 4) in vec4 inColor;
+
+#include "include/uniforms.glsl"
+
+out vec2 texCoord;
+out vec4 color;
+
+void main() {
+    vec3 camera_right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 camera_up = vec3(view[0][1], view[1][1], view[2][1]);
+
+    vec3 vertex = inPosition
+    + camera_right * inVertex.x * inSize.x
+    + camera_up * inVertex.y * inSize.y;
+
+    gl_Position = viewProjection * vec4(vertex, 1.f);
+
+    texCoord = inUvRect.xy + (inVertex + vec2(0.5, 0.5)) * inUvRect.zw;
+    color = inColor;
+}
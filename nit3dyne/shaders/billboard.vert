@@ -1,10 +1,8 @@
 #version 330 core
 layout (location = 0) in vec2 inVertex;
 
-// TODO: pre-multiply these
-uniform mat4 vp;
-uniform vec3 camera_right;
-uniform vec3 camera_up;
+#include "include/uniforms.glsl"
+
 uniform vec3 position;
 uniform vec2 size;
 uniform bool viewScale;
@@ -12,6 +10,10 @@ uniform bool viewScale;
 out vec2 texCoord;
 
 void main() {
+    mat4 vp = viewProjection;
+    vec3 camera_right = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 camera_up = vec3(view[0][1], view[1][1], view[2][1]);
+
     vec3 vertex = vec3(inVertex, 0.f);
 
     if (viewScale) {
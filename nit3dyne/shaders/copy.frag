@@ -1,12 +0,0 @@
-#version 330 core
-
-out vec4 fragColor;
-
-in vec2 texCoord;
-
-uniform sampler2D tex;
-
-void main()
-{
-    fragColor = texture(tex, texCoord);
-}
\ No newline at end of file
@@ -0,0 +1,45 @@
+// Clustered point and spot lights, see graphics/light_clusters.h. Needs uniforms.glsl.
+
+uniform samplerBuffer lightBuffer;    // Five texels per light, view space
+uniform usamplerBuffer lightClusters; // Index offset and count per cluster
+uniform usamplerBuffer lightIndices;
+
+// clipPos before vertex snapping, vertPos and normal in view space
+vec3 clusterLights(vec4 clipPos, vec3 vertPos, vec3 normal,
+                   vec3 ambient, vec3 diffuse, vec3 specular, float shininess) {
+   vec3 color = vec3(0.0);
+   if (clusterGrid.w < 1.0 || clipPos.w <= 0.0) return color;
+
+   ivec3 grid = ivec3(clusterGrid.xyz);
+   ivec2 tile = clamp(ivec2(floor((clipPos.xy / clipPos.w * 0.5 + 0.5) * clusterGrid.xy)), ivec2(0), grid.xy - 1);
+   int slice = clamp(int(floor(log(max(-vertPos.z, 1e-4)) * clusterDepth.x + clusterDepth.y)), 0, grid.z - 1);
+   uvec2 cluster = texelFetch(lightClusters, (slice * grid.y + tile.y) * grid.x + tile.x).xy;
+
+   vec3 viewDir = normalize(-vertPos);
+   for (uint i = 0u; i < cluster.y; ++i) {
+      int light = int(texelFetch(lightIndices, int(cluster.x + i)).r) * 5;
+      vec4 position = texelFetch(lightBuffer, light);
+      vec4 lAmbient = texelFetch(lightBuffer, light + 1);
+      vec4 lDiffuse = texelFetch(lightBuffer, light + 2);
+      vec4 lSpecular = texelFetch(lightBuffer, light + 3);
+      vec4 direction = texelFetch(lightBuffer, light + 4);
+
+      vec3 toLight = position.xyz - vertPos;
+      float dist = length(toLight);
+      if (dist >= position.w) continue;
+      vec3 lightDir = toLight / dist;
+
+      // Point lights have no direction and a cut off below -1
+      if (dot(-lightDir, direction.xyz) <= lAmbient.w) continue;
+
+      // Faded out towards the range so lights never end at a cluster edge
+      float att = (1.0 - dist / position.w) / (lDiffuse.w + lSpecular.w * dist + direction.w * dist * dist);
+
+      vec3 reflectDir = reflect(-lightDir, normal);
+      color += att * (lAmbient.rgb * ambient
+                      + lDiffuse.rgb * max(dot(normal, lightDir), 0.0) * diffuse
+                      + lSpecular.rgb * pow(max(dot(viewDir, reflectDir), 0.0), shininess) * specular);
+   }
+
+   return color;
+}
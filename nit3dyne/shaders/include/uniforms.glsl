@@ -0,0 +1,33 @@
+// Shared per-frame blocks, bound to fixed binding points by Shader (see graphics/frame_uniforms.h)
+
+struct DLight {
+   vec4 direction;
+
+   vec3 ambient;
+   vec3 diffuse;
+   vec3 specular;
+};
+
+struct SLight {
+   vec4 position;
+   vec4 direction;
+
+   float cutOff;
+};
+
+layout (std140) uniform FrameData {
+   mat4 projection;
+   mat4 view;
+   mat4 viewProjection;
+   vec4 cameraPosition;
+   vec4 viewPort;
+   vec4 time;
+};
+
+// View space
+layout (std140) uniform LightData {
+   DLight dLight;
+   SLight sLight;
+   vec4 clusterGrid;  // Tiles x, y, depth slices, clustered lights
+   vec4 clusterDepth; // Scale and bias of the log depth slicing
+};
@@ -6,7 +6,8 @@ out VS_OUT {
     vec3 normal;
 } vs_out;
 
-uniform mat4 view;
+#include "include/uniforms.glsl"
+
 uniform mat4 model;
 
 void main()
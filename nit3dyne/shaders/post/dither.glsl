@@ -0,0 +1,11 @@
+// Ordered dither down to 32 levels per channel, one pattern texel per input pixel
+uniform sampler2D texDither;
+
+vec4 dither(vec4 color, vec2 uv) {
+    const float colorDepth = 32.0;
+    vec2 scale = vec2(textureSize(tex, 0)) / vec2(textureSize(texDither, 0));
+
+    vec3 offset = texture(texDither, uv * scale).rgb - 0.5;
+    color.rgb = floor(color.rgb * colorDepth + offset) / colorDepth;
+    return color;
+}
@@ -0,0 +1,19 @@
+// Film grain, grainSeed changes every frame
+uniform float grainSeed;
+
+float grainRand(vec2 p) {
+    vec2 k1 = vec2(
+        23.14069263277926, // e^pi (Gelfond's constant)
+        2.665144142690225 // 2^sqrt(2) (Gelfond–Schneider constant)
+    );
+    return fract(
+        cos(dot(p, k1)) * 12345.6789
+    );
+}
+
+vec4 grain(vec4 color, vec2 uv) {
+    float strength = 0.0777;
+    vec2 uvNoise = uv;
+    uvNoise.y *= grainRand(vec2(uvNoise.y, grainSeed));
+    return color + vec4(grainRand(uvNoise) * strength);
+}
@@ -4,10 +4,10 @@ layout (location = 0) in vec3 inVertex;
 
 out vec3 texCoord;
 
-uniform mat4 proj;
-uniform mat4 view;
+#include "include/uniforms.glsl"
 
 void main() {
-    gl_Position = vec4(proj * view * vec4(inVertex, 1.0)).xyww;
+    // Rotation only, the sky stays centered on the camera
+    gl_Position = vec4(projection * mat4(mat3(view)) * vec4(inVertex, 1.0)).xyww;
     texCoord = inVertex;
 }
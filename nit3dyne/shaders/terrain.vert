@@ -12,13 +12,8 @@ struct Material {
    float shininess;
 };
 
-struct DLight {
-   vec4 direction;
-
-   vec3 ambient;
-   vec3 diffuse;
-   vec3 specular;
-};
+#include "include/uniforms.glsl"
+#include "include/lights.glsl"
 
 out vec3 lightColor;
 out vec3 affineUv;
@@ -29,11 +24,11 @@ uniform mat4 modelView;
 uniform mat4 mvp;
 
 uniform Material material;
-uniform DLight dLight;
 
 void main() {
    // Vertex snapping
-   vec4 vertex = mvp * vec4(inVertex, 1.0);
+   vec4 clipPos = mvp * vec4(inVertex, 1.0);
+   vec4 vertex = clipPos;
    vertex.xyz = vertex.xyz / vertex.w;
    vertex.x = floor(160 * vertex.x) / 160;
    vertex.y = floor(120 * vertex.y) / 120;
@@ -46,7 +41,8 @@ void main() {
 
    vec3 ambient = dLight.ambient.xyz * material.ambient;
    vec3 diffuse = dLight.diffuse.xyz * (max(dot(normal, lightDir), 0.0) * material.diffuse);
-   lightColor = diffuse + ambient;
+   vec3 clustered = clusterLights(clipPos, vertPos, normal, material.ambient, material.diffuse, vec3(0.0), 1.0);
+   lightColor = diffuse + ambient + clustered;
 
    // Affine texture map
    affineUv = vec3(inTexCoord.st * vertPos.z, vertPos.z);
@@ -0,0 +1,76 @@
+#version 330 core
+
+layout (location = 0) in vec3 inVertex;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec3 inColor;
+layout (location = 5) in mat4 inModel; // Per instance, locations 5-8
+layout (location = 9) in vec4 inTint;
+
+struct Material {
+   vec3 ambient;
+   vec3 diffuse;
+   vec3 specular;
+   float shininess;
+};
+
+#include "include/uniforms.glsl"
+#include "include/lights.glsl"
+
+out vec3 lightColor;
+out vec3 color;
+
+uniform vec3 sunPosition;
+uniform vec3 sunColor;
+
+uniform Material material;
+
+#include "include/constant.glsl"
+
+void main() {
+   mat4 modelView = view * inModel;
+   mat4 mvp = projection * modelView;
+   // Instances are uniformly scaled, the rotation part works as the normal matrix
+   mat3 normalMat = mat3(modelView);
+
+   // Vertex snapping
+   vec4 clipPos = mvp * vec4(inVertex, 1.0);
+   vec4 vertex = clipPos;
+   vertex.xyz = vertex.xyz / vertex.w;
+   vertex.x = floor(160 * vertex.x) / 160;
+   vertex.y = floor(120 * vertex.y) / 120;
+   vertex.xyz *= vertex.w;
+   gl_Position = vertex;
+
+   vec3 normal = normalize(normalMat * inNormal);
+   vec3 vertPos = vec3(modelView * vec4(inVertex, 1.0));
+   vec3 lightDir = normalize(-dLight.direction.xyz);
+
+   // SpotLight
+   vec3 sLightDir = normalize(sLight.position.xyz - vertPos);
+   float theta = dot(sLightDir, normalize(-sLight.direction.xyz));
+
+   vec3 sLightColor = vec3(0.0, 0.0, 0.0);
+   if (theta > sLight.cutOff) {
+      float dist = length(sLight.position.xyz - vertPos);
+      float att =  1.0 / (dist/4 /* intensity */);
+      sLightColor = vec3(.65/2, .6/2, .5/2) * att;
+   }
+
+   // Ambient
+   vec3 ambient = dLight.ambient.xyz * material.ambient; // Ambient component
+
+   // Diffuse
+   vec3 diffuse = dLight.diffuse.xyz * (max(dot(normal, lightDir), 0.0) * material.diffuse);
+
+   // Specular
+   vec3 viewDir = normalize(-vertPos);
+   vec3 reflectDir = reflect(-lightDir, normal);
+   vec3 specular = dLight.specular.xyz * (
+      pow(max(dot(viewDir, reflectDir), 0.0), material.shininess) * material.specular
+   );
+
+   vec3 clustered = clusterLights(clipPos, vertPos, normal,
+                                  material.ambient, material.diffuse, material.specular, material.shininess);
+   lightColor = (ambient + diffuse + specular + sLightColor + clustered) * inTint.rgb;
+   color = inColor;
+}
@@ -16,20 +16,8 @@ struct Material {
    float shininess;
 };
 
-struct DLight {
-   vec4 direction;
-
-   vec3 ambient;
-   vec3 diffuse;
-   vec3 specular;
-};
-
-struct SLight {
-   vec4 position;
-   vec4 direction;
-
-   float cutOff;
-};
+#include "include/uniforms.glsl"
+#include "include/lights.glsl"
 
 out vec3 lightColor;
 out vec3 affineUv;
@@ -41,12 +29,13 @@ uniform vec3 sunColor;
 uniform mat3 normalMat;
 uniform mat4 modelView;
 uniform mat4 mvp;
-uniform mat4 jointTransforms[MAX_JOINTS];
 
-uniform Material material;
-uniform DLight dLight;
-uniform SLight sLight;
+// Written per draw into the uniform stream, see MeshAnimated::draw
+layout (std140) uniform JointPalette {
+   mat4 jointTransforms[MAX_JOINTS];
+};
 
+uniform Material material;
 
 void main() {
     //skinning
@@ -63,7 +52,8 @@ void main() {
     }
 
    // Vertex snapping
-   vec4 vertex = mvp * localVertex;
+   vec4 clipPos = mvp * localVertex;
+   vec4 vertex = clipPos;
    vertex.xyz = vertex.xyz / vertex.w;
    vertex.x = floor(160 * vertex.x) / 160;
    vertex.y = floor(120 * vertex.y) / 120;
@@ -75,7 +65,6 @@ void main() {
 
    vec3 lightDir = normalize(-dLight.direction.xyz);
 
-
    // SpotLight
    vec3 sLightDir = normalize(sLight.position.xyz - vertPos);
    float theta = dot(sLightDir, normalize(-sLight.direction.xyz));
@@ -100,7 +89,9 @@ void main() {
       pow(max(dot(viewDir, reflectDir), 0.0), material.shininess) * material.specular
    );
 
-   lightColor = ambient + diffuse + specular + sLightColor;
+   vec3 clustered = clusterLights(clipPos, vertPos, normal,
+                                  material.ambient, material.diffuse, material.specular, material.shininess);
+   lightColor = ambient + diffuse + specular + sLightColor + clustered;
 
    // Affine texture map
    affineUv = vec3(inTexCoord.st * vertPos.z, vertPos.z);
@@ -11,20 +11,8 @@ struct Material {
    float shininess;
 };
 
-struct DLight {
-   vec4 direction;
-
-   vec3 ambient;
-   vec3 diffuse;
-   vec3 specular;
-};
-
-struct SLight {
-   vec4 position;
-   vec4 direction;
-
-   float cutOff;
-};
+#include "include/uniforms.glsl"
+#include "include/lights.glsl"
 
 out vec3 lightColor;
 out vec3 affineUv;
@@ -38,13 +26,11 @@ uniform mat4 modelView;
 uniform mat4 mvp;
 
 uniform Material material;
-uniform DLight dLight;
-uniform SLight sLight;
-
 
 void main() {
    // Vertex snapping
-   vec4 vertex = mvp * vec4(inVertex, 1.0);
+   vec4 clipPos = mvp * vec4(inVertex, 1.0);
+   vec4 vertex = clipPos;
    vertex.xyz = vertex.xyz / vertex.w;
    vertex.x = floor(160 * vertex.x) / 160;
    vertex.y = floor(120 * vertex.y) / 120;
@@ -55,7 +41,6 @@ void main() {
    vec3 vertPos = vec3(modelView * vec4(inVertex, 1.0));
    vec3 lightDir = normalize(-dLight.direction.xyz);
 
-
    // SpotLight
    vec3 sLightDir = normalize(sLight.position.xyz - vertPos);
    float theta = dot(sLightDir, normalize(-sLight.direction.xyz));
@@ -80,7 +65,9 @@ void main() {
       pow(max(dot(viewDir, reflectDir), 0.0), material.shininess) * material.specular
    );
 
-   lightColor = ambient + diffuse + specular + sLightColor;
+   vec3 clustered = clusterLights(clipPos, vertPos, normal,
+                                  material.ambient, material.diffuse, material.specular, material.shininess);
+   lightColor = ambient + diffuse + specular + sLightColor + clustered;
 
    // Affine texture map
    affineUv = vec3(inTexCoord.st * vertPos.z, vertPos.z);
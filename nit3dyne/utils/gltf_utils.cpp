@@ -26,4 +26,66 @@ void emplaceData(float *src, std::vector<mat4> &dst) {
     );
 }
 
+static double readComponent(const unsigned char *src, int componentType, bool normalized) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_BYTE: {
+            auto v = *(const int8_t *) src;
+            return normalized ? std::max(v / 127., -1.) : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+            auto v = *(const uint8_t *) src;
+            return normalized ? v / 255. : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_SHORT: {
+            auto v = *(const int16_t *) src;
+            return normalized ? std::max(v / 32767., -1.) : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+            auto v = *(const uint16_t *) src;
+            return normalized ? v / 65535. : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_INT:
+            return *(const int32_t *) src;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            return *(const uint32_t *) src;
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            return *(const float *) src;
+        case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+            return *(const double *) src;
+        default:
+            return 0.;
+    }
+}
+
+template<typename T>
+static int readAccessorAs(const tinygltf::Model &model, int accessorId, std::vector<T> &data) {
+    const tinygltf::Accessor &accessor = model.accessors[accessorId];
+    const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
+    const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
+
+    int components = tinygltf::GetNumComponentsInType(accessor.type);
+    int componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+    int stride = accessor.ByteStride(bufferView);
+    if (components < 0 || componentSize < 0 || stride < 0) return 0;
+
+    const unsigned char *base = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+    data.reserve(data.size() + accessor.count * components);
+
+    for (size_t i = 0; i < accessor.count; ++i) {
+        const unsigned char *element = base + i * stride;
+        for (int c = 0; c < components; ++c)
+            data.push_back((T) readComponent(element + c * componentSize, accessor.componentType, accessor.normalized));
+    }
+
+    return components;
+}
+
+int readAccessor(const tinygltf::Model &model, int accessorId, std::vector<float> &data) {
+    return readAccessorAs<float>(model, accessorId, data);
+}
+
+int readAccessor(const tinygltf::Model &model, int accessorId, std::vector<uint32_t> &data) {
+    return readAccessorAs<uint32_t>(model, accessorId, data);
+}
+
 }
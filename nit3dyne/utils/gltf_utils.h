@@ -16,6 +16,12 @@ void emplaceData(float *src, std::vector<vec4> &dst);
 
 void emplaceData(float *src, std::vector<mat4> &dst);
 
+// Reads an accessor of any component type as floats, normalizing integer data if flagged
+int readAccessor(const tinygltf::Model &model, int accessorId, std::vector<float> &data);
+
+// Reads an integer accessor (indices, joints), returns the number of components per element
+int readAccessor(const tinygltf::Model &model, int accessorId, std::vector<uint32_t> &data);
+
 template<typename T>
 void readBuffer(tinygltf::Accessor &accessor, tinygltf::Model &model, std::vector<T> &data) {
     tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
@@ -0,0 +1,83 @@
+#include "golden_image.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include "nit3dyne/graphics/texture.h"
+
+namespace n3d {
+
+bool saveImage(const std::string &path, int width, int height, const unsigned char *rgb) {
+    // PNG rows go top down
+    size_t stride = (size_t) width * 3;
+    std::vector<unsigned char> flipped(stride * height);
+    for (int y = 0; y < height; ++y)
+        std::copy_n(rgb + stride * (height - 1 - y), stride, flipped.data() + stride * y);
+
+    if (!stbi_write_png(path.c_str(), width, height, 3, flipped.data(), (int) stride)) {
+        std::cout << "Image error: could not write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ImageDiff compareImages(const std::string &actualPath, const std::string &goldenPath, int tolerance,
+                        const std::string &diffPath) {
+    ImageDiff diff{false, 0, 0, 0, 0};
+
+    int width, height, channels;
+    int goldenWidth, goldenHeight, goldenChannels;
+    unsigned char *actual = loadImage(actualPath, &width, &height, &channels);
+    unsigned char *golden = loadImage(goldenPath, &goldenWidth, &goldenHeight, &goldenChannels);
+
+    if (actual == nullptr || golden == nullptr) {
+        std::cout << "Image error: could not read " << (actual == nullptr ? actualPath : goldenPath) << std::endl;
+    } else if (width != goldenWidth || height != goldenHeight) {
+        std::cout << "Image error: " << actualPath << " is " << width << "x" << height << ", " << goldenPath
+                  << " is " << goldenWidth << "x" << goldenHeight << std::endl;
+    } else {
+        diff = {true, width, height, 0, 0};
+        std::vector<unsigned char> marked(diffPath.empty() ? 0 : (size_t) width * height * 3);
+
+        for (size_t pixel = 0; pixel < (size_t) width * height; ++pixel) {
+            int largest = 0;
+            for (int c = 0; c < 3; ++c) {
+                // Gray images repeat their one channel
+                int a = actual[pixel * channels + std::min(c, channels - 1)];
+                int g = golden[pixel * goldenChannels + std::min(c, goldenChannels - 1)];
+                largest = std::max(largest, std::abs(a - g));
+                if (!marked.empty()) marked[pixel * 3 + c] = (unsigned char) (a / 4);
+            }
+
+            diff.maxDifference = std::max(diff.maxDifference, largest);
+            if (largest <= tolerance) continue;
+
+            ++diff.differing;
+            if (!marked.empty()) {
+                marked[pixel * 3] = 255;
+                marked[pixel * 3 + 1] = 0;
+                marked[pixel * 3 + 2] = 0;
+            }
+        }
+
+        if (!marked.empty() && !stbi_write_png(diffPath.c_str(), width, height, 3, marked.data(), width * 3))
+            std::cout << "Image error: could not write " << diffPath << std::endl;
+    }
+
+    stbi_image_free(actual);
+    stbi_image_free(golden);
+    return diff;
+}
+
+bool matchesGolden(const std::string &actualPath, const std::string &goldenPath, int tolerance,
+                   size_t allowedPixels) {
+    ImageDiff diff = compareImages(actualPath, goldenPath, tolerance);
+    return diff.loaded && diff.differing <= allowedPixels;
+}
+
+}
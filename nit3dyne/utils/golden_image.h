@@ -0,0 +1,32 @@
+#ifndef GL_GOLDEN_IMAGE_H
+#define GL_GOLDEN_IMAGE_H
+
+#include <cstddef>
+#include <string>
+
+namespace n3d {
+
+// Outcome of comparing a rendered image with a reference one
+struct ImageDiff {
+    bool loaded;        // Both images read and the same size, nothing else is set otherwise
+    int width;
+    int height;
+    size_t differing;   // Pixels with a channel off by more than the tolerance
+    int maxDifference;  // Largest channel difference over all pixels
+};
+
+// Tightly packed 8 bit RGB, rows bottom up as glReadPixels returns them
+bool saveImage(const std::string &path, int width, int height, const unsigned char *rgb);
+
+// Compares the RGB channels of two image files. A pixel differs when any channel is off by more than tolerance.
+// With a diff path, differing pixels are written red over a dimmed copy of the actual image.
+ImageDiff compareImages(const std::string &actualPath, const std::string &goldenPath, int tolerance,
+                        const std::string &diffPath = "");
+
+// Passes when at most allowedPixels differ
+bool matchesGolden(const std::string &actualPath, const std::string &goldenPath, int tolerance,
+                   size_t allowedPixels = 0);
+
+}
+
+#endif // GL_GOLDEN_IMAGE_H
@@ -0,0 +1,32 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace n3d {
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED) {
+            this->mapping = static_cast<const unsigned char *>(ptr);
+            this->length = st.st_size;
+        }
+    }
+
+    // Mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (this->mapping != nullptr)
+        munmap((void *) this->mapping, this->length);
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef GL_MAPPED_FILE_H
+#define GL_MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+namespace n3d {
+
+// Read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const unsigned char *data() const { return this->mapping; }
+
+    size_t size() const { return this->length; }
+
+private:
+    const unsigned char *mapping = nullptr;
+    size_t length = 0;
+};
+
+}
+
+#endif // GL_MAPPED_FILE_H